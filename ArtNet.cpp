@@ -18,9 +18,59 @@
 */
 
 #include "ArtNet.h"
+#include "ArtNetMerge.h"
+#include "ArtNetSync.h"
+#include "ArtNetPixelMap.h"
+#include "ArtNetChange.h"
+#include "ArtNetDiscovery.h"
+#include "ArtNetTransmit.h"
+#include "ArtNetMetrics.h"
+#include "ArtNetDiagnostics.h"
+#include "ArtNetRdm.h"
+#include "ArtNetTimecode.h"
+#include "ArtNetSacn.h"
 #include <EEPROM.h>
+#include <stddef.h>
 
-#define htons(x) ( ((x)<<8) | (((x)>>8)&0xFF) )
+#define htons(x) ( (((x)<<8)&0xFF00) | (((x)>>8)&0xFF) )
+
+// Marks an unused slot in the dispatch table (Port-Address is only 15 bits)
+#define ARTNET_DISPATCH_EMPTY 0xffff
+// Terminates a chain of ports sharing a Port-Address
+#define ARTNET_DISPATCH_END 0xffff
+// Length of an ArtIpProgReply
+#define ARTNET_IP_PROG_REPLY_SIZE 34
+// Length of an ArtPoll
+#define ARTNET_POLL_SIZE 14
+// Passed to outputDirty() for the pixel maps, above any port
+#define ARTNET_DIRTY_PIXELS 0xffff
+// Passed to dispatchDmx() for frames with no ArtDmx sequence number
+#define ARTNET_SEQUENCE_NONE 0x100
+
+// Offsets of the original (pre-versioned) configuration layout, only used
+// to migrate nodes that were configured by an older library
+#define ARTNET_LEGACY_PORTS           4
+#define ARTNET_LEGACY_MAGIC           0
+#define ARTNET_LEGACY_SHORT_NAME      1
+#define ARTNET_LEGACY_LONG_NAME       (ARTNET_LEGACY_SHORT_NAME + 18)
+#define ARTNET_LEGACY_SUBNET          (ARTNET_LEGACY_LONG_NAME + 64)
+#define ARTNET_LEGACY_IP_CHANGED      (ARTNET_LEGACY_SUBNET + 1)
+#define ARTNET_LEGACY_INPUT_UNIVERSE  (ARTNET_LEGACY_IP_CHANGED + 1)
+#define ARTNET_LEGACY_OUTPUT_UNIVERSE (ARTNET_LEGACY_INPUT_UNIVERSE + ARTNET_LEGACY_PORTS)
+#define ARTNET_LEGACY_PORT_TYPE       (ARTNET_LEGACY_OUTPUT_UNIVERSE + ARTNET_LEGACY_PORTS)
+#define ARTNET_LEGACY_REPLY_IP        (ARTNET_LEGACY_PORT_TYPE + ARTNET_LEGACY_PORTS)
+#define ARTNET_LEGACY_REPLY_PORT      (ARTNET_LEGACY_REPLY_IP + 4)
+#define ARTNET_LEGACY_SIZE            (ARTNET_LEGACY_REPLY_PORT + 2)
+
+#define ARTNET_LEGACY_MAGIC_VALUE 253
+
+// GoodOutput bits in ArtPollReply
+#define ARTNET_GOOD_OUTPUT_DATA    (1 << 7)
+#define ARTNET_GOOD_OUTPUT_MERGING (1 << 3)
+#define ARTNET_GOOD_OUTPUT_LTP     (1 << 1)
+// GoodInput bits in ArtPollReply
+#define ARTNET_GOOD_INPUT_DATA     (1 << 7)
+#define ARTNET_GOOD_INPUT_DISABLED (1 << 3)
 
 /**************************************************************************
  * Types
@@ -32,6 +82,7 @@ typedef enum ArtNetOpCodeTag
 	ARTNET_OP_POLL_REPLY = 0x2100,
 	ARTNET_OP_DIAG_DATA = 0x2300,
 	ARTNET_OP_OUTPUT = 0x5000,
+	ARTNET_OP_SYNC = 0x5200,
 	ARTNET_OP_ADDRESS = 0x6000,
 	ARTNET_OP_INPUT = 0x7000,
 	ARTNET_OP_TOD_REQUEST = 0x8000,
@@ -58,26 +109,19 @@ ArtNetOpCode;
 
 typedef struct
 {
-	ArtNetOpCode opcode;
+	// Stored as uint16_t rather than ArtNetOpCode so that the header is four
+	// bytes on every target, enums are wider than 16 bits off AVR
+	uint16_t opcode;
 	
 	uint8_t protocol_hi;
 	uint8_t protocol_lo;
 }
 artnetheader_t;
 
-typedef enum ArtNetPriorityTag
-{
-	ARTNET_DIAGNOSTIC_LOW = 0x10,
-	ARTNET_DIAGNOSTIC_MED = 0x40,
-	ARTNET_DIAGNOSTIC_HIGH = 0x80,
-	ARTNET_DIAGNOSTIC_CRITICAL = 0xe0,
-	ARTNET_DIAGNOSTIC_VOLATILE = 0xff
-}
-ArtNetPriority;
-
+// ArtPoll TalkToMe bits, as laid out by Art-Net 4
 typedef enum ArtNetTalkToMeTag
 {
-	ARTNET_DIAGNOSTIC_BROADCAST = (1 << 3),  // Set if ArtNetPollReply should broadcast
+	ARTNET_DIAGNOSTIC_UNICAST = (1 << 3),    // Set if diagnostic messages should be unicast, clear to broadcast
 	ARTNET_DIAGNOSTIC_SEND = (1 << 2),       // Set if diagnostic messages should be sent
 	ARTNET_DIAGNOSTIC_ALWAYS = (1 << 1)      // Set if ArtNetPollReply should be sent whenever changes occur
 }
@@ -86,16 +130,114 @@ ArtNetTalkToMe;
 static char ARTNET_STATUS_STRING_OK[] = "Node Ok";
 static char ArtNetMagic[] = "Art-Net";
 
+// CRC of a configuration blob, up to the CRC at its end
+static unsigned short configCrc(const byte *data, word size)
+{
+    unsigned short crc = 0xffff;
+    unsigned char bit;
+    word i;
+
+    for (i = 0; i < size - 2; ++i) {
+        crc ^= (unsigned short)data[i] << 8;
+        for (bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+void ArtNetBucketSet(ArtNetBucket_t *bucket, unsigned char burst, unsigned int period, unsigned long now)
+{
+    if (burst == 0) burst = 1;
+    bucket->burst = burst;
+    bucket->period = period;
+    bucket->tokens = burst;
+    bucket->refill = now;
+}
+
+unsigned char ArtNetBucketTake(ArtNetBucket_t *bucket, unsigned long now, unsigned char wanted)
+{
+    unsigned long refilled;
+    
+    if (bucket->period == 0) {
+        bucket->tokens = bucket->burst;
+    } else if (bucket->tokens >= bucket->burst) {
+        // A full bucket doesn't save up time
+        bucket->refill = now;
+    } else {
+        refilled = (now - bucket->refill) / bucket->period;
+        if (refilled) {
+            bucket->refill += refilled * bucket->period;
+            if (refilled > (unsigned long)(bucket->burst - bucket->tokens)) {
+                refilled = bucket->burst - bucket->tokens;
+            }
+            bucket->tokens += refilled;
+        }
+    }
+    
+    if (wanted > bucket->tokens) wanted = bucket->tokens;
+    bucket->tokens -= wanted;
+    return wanted;
+}
+
+static inline unsigned short dispatchHash(unsigned short address, unsigned short mask)
+{
+    return (address ^ (address >> 4) ^ (address >> 8)) & mask;
+}
+
+static ArtNetMetricOpcode metricOpcode(unsigned short opcode)
+{
+    switch (opcode) {
+        case ARTNET_OP_POLL: return ARTNET_METRIC_POLL;
+        case ARTNET_OP_POLL_REPLY: return ARTNET_METRIC_POLL_REPLY;
+        case ARTNET_OP_OUTPUT: return ARTNET_METRIC_DMX;
+        case ARTNET_OP_SYNC: return ARTNET_METRIC_SYNC;
+        case ARTNET_OP_ADDRESS: return ARTNET_METRIC_ADDRESS;
+        case ARTNET_OP_INPUT: return ARTNET_METRIC_INPUT;
+        case ARTNET_OP_IP_PROG: return ARTNET_METRIC_IP_PROG;
+        case ARTNET_OP_DIAG_DATA: return ARTNET_METRIC_DIAG;
+        case ARTNET_OP_RDM:
+        case ARTNET_OP_RDM_SUB:
+        case ARTNET_OP_TOD_REQUEST:
+        case ARTNET_OP_TOD_DATA:
+        case ARTNET_OP_TOD_CONTROL: return ARTNET_METRIC_RDM;
+        case ARTNET_OP_TIMECODE: return ARTNET_METRIC_TIMECODE;
+        default: return ARTNET_METRIC_OTHER;
+    }
+}
+
 /* Implementation */
 
-ArtNet::ArtNet(byte *mac, byte eepromaddress, byte *buffer, word buflen, void (*setIP)(IPConfiguration, const char*, const char*), void (*sendFunc)(size_t, word, byte*, word), void (*callback)(unsigned short, const char *, unsigned short), unsigned char ports)
+ArtNetBase::ArtNetBase()
 {
-    if (ports > MAX_PORTS) {
-        ports = MAX_PORTS;
+    // Nothing is usable until ArtNetNode<> hands over its storage to begin()
+}
+
+void ArtNetBase::begin(const ArtNetStorage_t *storage, byte *mac, byte eepromaddress, byte *txBuffer, word txLength, void (*setIP)(IPConfiguration, const char*, const char*), void (*sendFunc)(const byte*, size_t, word, byte*, word), void (*callback)(unsigned short, const char *, unsigned short), unsigned short ports)
+{
+    if (ports > storage->ports) {
+        ports = storage->ports;
     }
+    this->Ports = ports;
+    this->ArtNetPortCapacity = storage->ports;
+    this->ArtNetPorts = storage->port;
+    this->ArtNetDispatchAddress = storage->dispatchAddress;
+    this->ArtNetDispatchPort = storage->dispatchPort;
+    this->ArtNetDispatchMask = storage->dispatchSlots - 1;
+    this->ArtNetPollReply = storage->pollReply;
+    // A node without ports still replies to polls
+    this->ArtNetPages = ports ? ARTNET_PAGES(ports) : 1;
     
-    unsigned char i;
-    unsigned char v;
+    // Carve the configuration blob up in to its parts
+    this->ArtNetConfigBlob = storage->config;
+    this->ArtNetConfigSize = ARTNET_CONFIG_SIZE(storage->ports);
+    this->ArtNetConfigDirty = storage->configDirty;
+    this->ArtNetConfig = (ArtNetConfig_t*)storage->config;
+    this->ArtNetConfigInput = storage->config + sizeof(ArtNetConfig_t);
+    this->ArtNetConfigOutput = this->ArtNetConfigInput + storage->ports;
+    this->ArtNetConfigType = this->ArtNetConfigOutput + storage->ports;
+    this->ArtNetConfigPages = this->ArtNetConfigType + storage->ports;
+    this->ArtNetConfigTail = (ArtNetConfigTail_t*)(this->ArtNetConfigPages + 2 * (ARTNET_PAGES(storage->ports) - 1));
     
     this->broadcastIP[0] = 255;
     this->broadcastIP[1] = 255;
@@ -108,83 +250,108 @@ ArtNet::ArtNet(byte *mac, byte eepromaddress, byte *buffer, word buflen, void (*
     this->mac = mac;
     this->eepromaddress = eepromaddress;
     
-    this->buffer = buffer;
-    this->buflen = buflen;
+    this->txBuffer = txBuffer;
+    this->txLength = txLength;
     this->sendFunc = sendFunc;
+    this->sendBatch = 0;
+    this->ArtNetSendQueue = 0;
+    this->ArtNetSendQueueSize = 0;
+    this->ArtNetSendQueued = 0;
+    this->ArtNetBatching = 0;
+    this->ArtNetReplica = 0;
     this->callback = callback;
     this->setIP = setIP;
     
     this->ArtNetDiagnosticPriority = ARTNET_DIAGNOSTIC_CRITICAL;
-    this->ArtNetDiagnosticStatus = ARTNET_DIAGNOSTIC_BROADCAST | ARTNET_DIAGNOSTIC_SEND | ARTNET_DIAGNOSTIC_ALWAYS;
+    this->ArtNetDiagnosticStatus = ARTNET_DIAGNOSTIC_SEND | ARTNET_DIAGNOSTIC_ALWAYS;
+    this->ArtNetDiag = 0;
+    this->ArtNetDiagnosticWanted = 1;
+    this->ArtNetDiagnosticFloor = ARTNET_DIAGNOSTIC_CRITICAL;
     this->ArtNetCounter = 0;
+    this->ArtNetPollPending = 0;
+    this->ArtNetPollSuppressed = 0;
+    ArtNetBucketSet(&this->ArtNetPollBucket, ARTNET_POLL_BURST, ARTNET_POLL_PERIOD, 0);
+    this->ArtNetDiscoveryTable = 0;
     this->ArtNetStatus = ARTNET_STATUS_POWER_OK;
     this->ArtNetStatusString = ARTNET_STATUS_STRING_OK;
-    v = EEPROM.read(eepromaddress);
-    if (v != 253) EEPROM.write(eepromaddress, 253);
-    if (v != 253) EEPROM.write(eepromaddress + 1 + 18 + 64, 0);
-    this->ArtNetSubnet = EEPROM.read(eepromaddress + 1 + 18 + 64);
-    if (this->ArtNetSubnet == 0xff) this->ArtNetSubnet = 0;
+    this->ArtNetReportDirty = 1;
     this->ArtNetInCounter = 0;
     this->ArtNetFailCounter = 0;
     
-    memset(this->ArtNetInputPortStatus, 0, MAX_PORTS);
-    memset(this->ArtNetOutputPortStatus, 0, MAX_PORTS);
-    for (i = 0; i < MAX_PORTS; ++i) {
-        if (v != 253) EEPROM.write(eepromaddress + 1 + 18 + 64 + 2 + i, i);
-        this->ArtNetInputUniverse[i] = EEPROM.read(eepromaddress + 1 + 18 + 64 + 2 + i);
-        if (v != 253) EEPROM.write(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + i, i);
-        this->ArtNetOutputUniverse[i] = EEPROM.read(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + i);
-        if (v != 253) {
-            if (i < ports) {
-                EEPROM.write(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + MAX_PORTS + i, ARTNET_IN);
-            } else {
-                EEPROM.write(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + MAX_PORTS + i, ARTNET_OFF);
-            }
-        }
-        this->ArtNetInputEnable[i] = (ArtNetPortType)EEPROM.read(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + MAX_PORTS + i);
-    }
+    this->loadConfig(ports);
     
-    /* Clear names if uninitialised */
-    if (v != 253) {
-        for (i = 0; i < 18; ++i) {
-            EEPROM.write(eepromaddress + 1 + i, 0);
-        }
-        for (i = 0; i < 64; ++i) {
-            EEPROM.write(eepromaddress + 1 + 18 + i, 0);
-        }
-    }
+    memset(this->ArtNetPorts, 0, this->ArtNetPortCapacity * sizeof(ArtNetPort_t));
+    this->ArtNetSequenceDropCounter = 0;
+    this->ArtNetSequenceReorderCounter = 0;
+    this->showFunc = 0;
+    this->ArtNetShowPeriod = 0;
+    this->ArtNetShowLast = 0;
+    this->ArtNetShowDirtySince = 0;
+    this->ArtNetOutputDirty = 0;
+    this->ArtNetOutputDirtyPorts = 0;
+    this->ArtNetOutputExpected = 0;
+    this->ArtNetSyncActive = 0;
+    this->ArtNetSyncSeen = 0;
+    this->ArtNetTimecodeClock = 0;
+    this->ArtNetSacnReceiver = 0;
+    this->ArtNetSkipCounter = 0;
+    this->rangeCallback = 0;
+    this->ArtNetTransmitPorts = 0;
+    this->ArtNetTransmitNext = 0;
+    this->ArtNetTransmitLast = 0;
+    this->ArtNetTransmitPolled = 0;
+    this->ArtNetRdmPorts = 0;
+    this->ArtNetMergePorts = 0;
+    this->ArtNetPixelMaps = 0;
+    this->ArtNetNodeMetrics = 0;
+    this->ip = 0;
+    this->dhcp = 0;
+    this->rebuildDispatch();
+    this->buildPollReply();
 }
 
-ArtNetPortType ArtNet::PortType(unsigned char port)
+unsigned short ArtNetBase::GetPorts()
 {
-    if (port > MAX_PORTS) return ARTNET_OFF;
-    return ArtNetInputEnable[port];
+    return this->Ports;
 }
 
-void ArtNet::PortType(unsigned char port, ArtNetPortType type)
+unsigned short ArtNetBase::GetPages()
 {
-    if (port > MAX_PORTS) return;
-    ArtNetInputEnable[port] = type;
+    return this->ArtNetPages;
 }
 
-void ArtNet::Configure(byte dhcp, byte* ip)
+ArtNetPortType ArtNetBase::PortType(unsigned short port)
+{
+    if (port >= this->ArtNetPortCapacity) return ARTNET_OFF;
+    return (ArtNetPortType)this->ArtNetConfigType[port];
+}
+
+unsigned char ArtNetBase::InputDisabled(unsigned short port)
+{
+    if (port >= this->ArtNetPortCapacity) return 0;
+    return this->ArtNetPorts[port].inputDisabled;
+}
+
+void ArtNetBase::PortType(unsigned short port, ArtNetPortType type)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    this->configWrite(&this->ArtNetConfigType[port], type);
+    this->patchChanged();
+}
+
+void ArtNetBase::Configure(byte dhcp, byte* ip)
 {
-    unsigned char i;
-    
     this->ip = ip;
     this->dhcp = dhcp;
+    this->buildPollReply();
     
-    if (EEPROM.read(eepromaddress + 1 + 18 + 64 + 1) == 1) {
+    if (this->ArtNetConfigTail->ipChanged == 1) {
         // Reboot due to IP change
-        EEPROM.write(eepromaddress + 1 + 18 + 64 + 1, 0);
+        this->configWrite(&this->ArtNetConfigTail->ipChanged, 0);
         byte sendIp[4];
         word sendPort;
-        for (i = 0; i < 4; ++i) {
-            sendIp[i] = EEPROM.read(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS * 3 + i);
-        }
-        for (i = 0; i < 2; ++i) {
-            ((byte*)&sendPort)[i] = EEPROM.read(eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS * 3 + 4 + i);
-        }
+        memcpy(sendIp, this->ArtNetConfigTail->replyIp, 4);
+        memcpy(&sendPort, this->ArtNetConfigTail->replyPort, 2);
     	this->sendIPProgReply(sendIp, sendPort);
     } else {
         // Standard boot
@@ -192,139 +359,672 @@ void ArtNet::Configure(byte dhcp, byte* ip)
     }
 }
 
-void ArtNet::GetShortName(char *shortName)
+unsigned char ArtNetBase::fromSelf(const byte ip[4])
+{
+    return this->ip && memcmp(ip, this->ip, 4) == 0;
+}
+
+void ArtNetBase::GetShortName(char *shortName)
 {
     unsigned char i;
     for (i = 0; i < 18; ++i) {
-        shortName[i] = EEPROM.read(this->eepromaddress + 1 + i);
+        shortName[i] = this->ArtNetConfig->shortName[i];
     }
 }
 
-void ArtNet::SetShortName(char *shortName)
+void ArtNetBase::SetShortName(char *shortName)
 {
     unsigned char i;
     for (i = 0; i < 18; ++i) {
-        EEPROM.write(this->eepromaddress + 1 + i, shortName[i]);
+        this->configWrite(&this->ArtNetConfig->shortName[i], shortName[i]);
         if (!shortName[i]) break;
     }
     for (; i < 18; ++i) {
-        EEPROM.write(this->eepromaddress + 1 + i, 0);
+        this->configWrite(&this->ArtNetConfig->shortName[i], 0);
     }
+    this->pollReplyNames();
 }
 
-void ArtNet::GetLongName(char *longName)
+void ArtNetBase::GetLongName(char *longName)
 {
     unsigned char i;
     for (i = 0; i < 64; ++i) {
-        longName[i] = EEPROM.read(this->eepromaddress + 1 + 18 + i);
+        longName[i] = this->ArtNetConfig->longName[i];
     }
 }
 
-void ArtNet::SetLongName(char *longName)
+void ArtNetBase::SetLongName(char *longName)
 {
     unsigned char i;
     for (i = 0; i < 64; ++i) {
-        EEPROM.write(this->eepromaddress + 1 + 18 + i, longName[i]);
+        this->configWrite(&this->ArtNetConfig->longName[i], longName[i]);
         if (!longName[i]) break;
     }
     for (; i < 64; ++i) {
-        EEPROM.write(this->eepromaddress + 1 + 18 + i, 0);
+        this->configWrite(&this->ArtNetConfig->longName[i], 0);
     }
+    this->pollReplyNames();
+}
+
+unsigned char ArtNetBase::GetInputUniverse(unsigned short port)
+{
+    if (port >= this->ArtNetPortCapacity) return 0;
+    return this->ArtNetConfigInput[port];
+}
+
+void ArtNetBase::SetInputUniverse(unsigned short port, unsigned char universe)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    this->configWrite(&this->ArtNetConfigInput[port], universe);
+    this->patchChanged();
+}
+
+unsigned char ArtNetBase::GetOutputUniverse(unsigned short port)
+{
+    if (port >= this->ArtNetPortCapacity) return 0;
+    return this->ArtNetConfigOutput[port];
+}
+
+void ArtNetBase::SetOutputUniverse(unsigned short port, unsigned char universe)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    this->configWrite(&this->ArtNetConfigOutput[port], universe);
+    this->patchChanged();
+}
+
+unsigned char ArtNetBase::GetSubnet()
+{
+    return this->GetPageSubnet(0);
+}
+
+void ArtNetBase::SetSubnet(unsigned char subnet)
+{
+    this->SetPageSubnet(0, subnet);
 }
 
-unsigned char ArtNet::GetInputUniverse(unsigned char port)
+unsigned char ArtNetBase::GetNet()
 {
-    if (port >= MAX_PORTS) return 0;
-    return this->ArtNetInputUniverse[port];
+    return this->GetPageNet(0);
 }
 
-void ArtNet::SetInputUniverse(unsigned char port, unsigned char universe)
+void ArtNetBase::SetNet(unsigned char net)
 {
-    if (port >= MAX_PORTS) return;
-    this->ArtNetInputUniverse[port] = universe;
-    EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 2 + port, universe);
+    this->SetPageNet(0, net);
 }
 
-unsigned char ArtNet::GetSubnet()
+unsigned char ArtNetBase::GetPageSubnet(unsigned short page)
 {
-    return this->ArtNetSubnet;
+    if (page >= ARTNET_PAGES(this->ArtNetPortCapacity)) return 0;
+    return *this->configSubnet(page);
 }
 
-void ArtNet::SetSubnet(unsigned char subnet)
+void ArtNetBase::SetPageSubnet(unsigned short page, unsigned char subnet)
 {
-    this->ArtNetSubnet = subnet;
-    EEPROM.write(this->eepromaddress + 1 + 18 + 64, subnet);
+    if (page >= ARTNET_PAGES(this->ArtNetPortCapacity)) return;
+    this->configWrite(this->configSubnet(page), subnet);
+    this->patchChanged();
 }
 
-unsigned int ArtNet::GetPacketCount()
+unsigned char ArtNetBase::GetPageNet(unsigned short page)
+{
+    if (page >= ARTNET_PAGES(this->ArtNetPortCapacity)) return 0;
+    return *this->configNet(page);
+}
+
+void ArtNetBase::SetPageNet(unsigned short page, unsigned char net)
+{
+    if (page >= ARTNET_PAGES(this->ArtNetPortCapacity)) return;
+    this->configWrite(this->configNet(page), net & 0x7f);
+    this->patchChanged();
+}
+
+void ArtNetBase::Service()
+{
+    // Anything sent is handed over in one batch at the end
+    this->ArtNetBatching = 1;
+
+    if (this->ArtNetConfigPending && millis() - this->ArtNetConfigChanged >= ARTNET_COMMIT_DELAY) {
+        // Only trickle the configuration out so the packet loop never stalls
+        this->flushConfig(ARTNET_COMMIT_BYTES);
+    }
+    
+    if (this->ArtNetTimecodeClock && this->ArtNetTimecodeClock->Due()) {
+        // A frame instant of the timecode, as if an ArtSync arrived
+        if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Arrive();
+        this->commitSync();
+    }
+    
+    if (this->ArtNetOutputDirty) {
+        this->serviceShow();
+    }
+    
+    if (this->ArtNetDiscoveryTable) {
+        this->ArtNetDiscoveryTable->Service(millis());
+    }
+    
+    if (this->ArtNetPollPending) {
+        this->servicePoll();
+    }
+    
+    if (this->ArtNetTransmitPorts) {
+        this->serviceTransmit();
+    }
+    
+    if (this->ArtNetRdmPorts) {
+        this->serviceRdm();
+    }
+    
+    if (this->ArtNetMergePorts) {
+        this->serviceMerge();
+    }
+    
+    if (this->ArtNetNodeMetrics) {
+        this->ArtNetNodeMetrics->Service(millis());
+    }
+    
+    if (this->ArtNetDiag && this->ArtNetDiag->Pending()) {
+        this->serviceDiagnostics();
+    }
+    
+    this->ArtNetBatching = 0;
+    this->flushSends();
+}
+
+void ArtNetBase::SetShow(void (*show)(void), unsigned int period)
+{
+    this->showFunc = show;
+    this->ArtNetShowPeriod = period;
+    this->clearDirty();
+}
+
+void ArtNetBase::serviceShow()
+{
+    unsigned long now = millis();
+    ArtNetPixelMap *map;
+    
+    if (now - this->ArtNetShowLast < this->ArtNetShowPeriod) {
+        // Never show more than once a period however fast data arrives
+        return;
+    }
+    
+    if (now - this->ArtNetShowDirtySince < this->ArtNetShowPeriod) {
+        // Give the rest of the frame's universes a period to arrive
+        if (this->ArtNetOutputDirtyPorts != this->ArtNetOutputExpected) {
+            return;
+        }
+        for (map = this->ArtNetPixelMaps; map; map = map->next) {
+            if (!map->Complete()) return;
+        }
+    }
+    
+    for (map = this->ArtNetPixelMaps; map; map = map->next) {
+        map->Shown();
+    }
+    
+    this->clearDirty();
+    this->ArtNetShowLast = now;
+    this->showFunc();
+}
+
+void ArtNetBase::Commit()
+{
+    while (this->ArtNetConfigPending) {
+        this->flushConfig(this->ArtNetConfigSize);
+    }
+}
+
+word ArtNetBase::configAddress(unsigned char slot)
+{
+    return this->eepromaddress + slot * this->ArtNetConfigSize;
+}
+
+unsigned char ArtNetBase::readConfig(unsigned char slot)
+{
+    word i, address = this->configAddress(slot);
+    
+    // Single pass over the whole blob
+    for (i = 0; i < this->ArtNetConfigSize; ++i) {
+        this->ArtNetConfigBlob[i] = EEPROM.read(address + i);
+    }
+    
+    // A blob saved for another number of ports has its CRC elsewhere
+    return this->ArtNetConfig->magic == ARTNET_CONFIG_MAGIC &&
+            this->ArtNetConfig->version == ARTNET_CONFIG_VERSION &&
+            configCrc(this->ArtNetConfigBlob, this->ArtNetConfigSize) == (this->ArtNetConfigTail->crc[0] | (this->ArtNetConfigTail->crc[1] << 8));
+}
+
+void ArtNetBase::loadConfig(unsigned short ports)
+{
+    unsigned char slot;
+    
+    memset(this->ArtNetConfigDirty, 0, (this->ArtNetConfigSize + 7) / 8);
+    this->ArtNetConfigPending = 0;
+    this->ArtNetConfigCrcStale = 0;
+    this->ArtNetConfigChanged = 0;
+    this->ArtNetConfigSlots = this->configAddress(2) <= (word)EEPROM.length() ? 2 : 1;
+    this->ArtNetConfigFlushing = 0;
+    
+    // The first slot is where a single blob has always been.  Both are whole
+    // if power was lost before the older one was given up, either will do.
+    for (slot = 0; slot < this->ArtNetConfigSlots; ++slot) {
+        if (this->readConfig(slot)) {
+            this->ArtNetConfigSlot = slot;
+            return;
+        }
+    }
+    
+    // Keep whatever is in the first slot until the second is saved
+    this->ArtNetConfigSlot = 0;
+    if (EEPROM.read(this->eepromaddress) == ARTNET_LEGACY_MAGIC_VALUE) {
+        this->migrateConfig(ports);
+    } else {
+        // Uninitialised or half written, fall back to the defaults
+        this->defaultConfig(ports);
+    }
+    
+    // Save the whole blob the next time it is flushed
+    memset(this->ArtNetConfigDirty, 0xff, (this->ArtNetConfigSize + 7) / 8);
+    this->ArtNetConfigPending = 1;
+    this->ArtNetConfigCrcStale = 1;
+}
+
+void ArtNetBase::migrateConfig(unsigned short ports)
+{
+    // The legacy layout shares the start of the blob, so copy it out first
+    byte legacy[ARTNET_LEGACY_SIZE];
+    ArtNetConfig_t *config = this->ArtNetConfig;
+    ArtNetConfigTail_t *tail = this->ArtNetConfigTail;
+    unsigned char i, count;
+    
+    for (i = 0; i < sizeof(legacy); ++i) {
+        legacy[i] = EEPROM.read(this->eepromaddress + i);
+    }
+    
+    this->defaultConfig(ports);
+    memcpy(config->shortName, &legacy[ARTNET_LEGACY_SHORT_NAME], 18);
+    memcpy(config->longName, &legacy[ARTNET_LEGACY_LONG_NAME], 64);
+    // The legacy layout had no Net, so it keeps the default of 0
+    if (legacy[ARTNET_LEGACY_SUBNET] != 0xff) config->subnet = legacy[ARTNET_LEGACY_SUBNET];
+    count = this->ArtNetPortCapacity < ARTNET_LEGACY_PORTS ? this->ArtNetPortCapacity : ARTNET_LEGACY_PORTS;
+    memcpy(this->ArtNetConfigInput, &legacy[ARTNET_LEGACY_INPUT_UNIVERSE], count);
+    memcpy(this->ArtNetConfigOutput, &legacy[ARTNET_LEGACY_OUTPUT_UNIVERSE], count);
+    memcpy(this->ArtNetConfigType, &legacy[ARTNET_LEGACY_PORT_TYPE], count);
+    tail->ipChanged = legacy[ARTNET_LEGACY_IP_CHANGED] == 1;
+    memcpy(tail->replyIp, &legacy[ARTNET_LEGACY_REPLY_IP], 4);
+    memcpy(tail->replyPort, &legacy[ARTNET_LEGACY_REPLY_PORT], 2);
+}
+
+void ArtNetBase::defaultConfig(unsigned short ports)
+{
+    ArtNetConfig_t *config = this->ArtNetConfig;
+    unsigned short i;
+    
+    memset(this->ArtNetConfigBlob, 0, this->ArtNetConfigSize);
+    config->magic = ARTNET_CONFIG_MAGIC;
+    config->version = ARTNET_CONFIG_VERSION;
+    for (i = 0; i < this->ArtNetPortCapacity; ++i) {
+        this->ArtNetConfigInput[i] = i & 0x0f;
+        this->ArtNetConfigOutput[i] = i & 0x0f;
+        this->ArtNetConfigType[i] = i < ports ? ARTNET_IN : ARTNET_OFF;
+    }
+    // Pages follow on from each other, so port n starts at Port-Address n
+    for (i = 1; i < ARTNET_PAGES(this->ArtNetPortCapacity); ++i) {
+        *this->configNet(i) = (i >> 6) & 0x7f;
+        *this->configSubnet(i) = (i >> 2) & 0x0f;
+    }
+}
+
+void ArtNetBase::configWrite(byte *field, byte value)
+{
+    word offset;
+    
+    if (*field == value) return;
+    *field = value;
+    if (this->ArtNetReplica) {
+        // The node it copies stores the configuration
+        return;
+    }
+    offset = field - this->ArtNetConfigBlob;
+    this->ArtNetConfigDirty[offset >> 3] |= 1 << (offset & 7);
+    this->ArtNetConfigPending = 1;
+    this->ArtNetConfigCrcStale = 1;
+    this->ArtNetConfigChanged = millis();
+}
+
+void ArtNetBase::configWrite(char *field, byte value)
+{
+    this->configWrite((byte*)field, value);
+}
+
+byte *ArtNetBase::configNet(unsigned short page)
+{
+    // The first page keeps its place in the head of the blob
+    return page ? &this->ArtNetConfigPages[2 * (page - 1)] : &this->ArtNetConfig->net;
+}
+
+byte *ArtNetBase::configSubnet(unsigned short page)
+{
+    return page ? &this->ArtNetConfigPages[2 * (page - 1) + 1] : &this->ArtNetConfig->subnet;
+}
+
+void ArtNetBase::flushConfig(word count)
+{
+    unsigned char bit, slot = (this->ArtNetConfigSlot + 1) % this->ArtNetConfigSlots;
+    word i, address = this->configAddress(slot);
+    
+    if (this->ArtNetConfigSlots > 1 && !this->ArtNetConfigFlushing) {
+        // The other slot holds an older blob, so every byte may differ
+        memset(this->ArtNetConfigDirty, 0xff, (this->ArtNetConfigSize + 7) / 8);
+        this->ArtNetConfigFlushing = 1;
+    }
+    
+    if (this->ArtNetConfigCrcStale) {
+        // The CRC is last in the blob so it is written after everything it
+        // covers, a partially written blob will fail the check on boot
+        unsigned short crc = configCrc(this->ArtNetConfigBlob, this->ArtNetConfigSize);
+        this->ArtNetConfigTail->crc[0] = crc & 0xff;
+        this->ArtNetConfigTail->crc[1] = crc >> 8;
+        for (i = this->ArtNetConfigSize - 2; i < this->ArtNetConfigSize; ++i) {
+            this->ArtNetConfigDirty[i >> 3] |= 1 << (i & 7);
+        }
+        this->ArtNetConfigCrcStale = 0;
+    }
+    
+    for (i = 0; i < (this->ArtNetConfigSize + 7) / 8; ++i) {
+        if (!this->ArtNetConfigDirty[i]) continue;
+        for (bit = 0; bit < 8; ++bit) {
+            if (!(this->ArtNetConfigDirty[i] & (1 << bit))) continue;
+            // Bits past the end of the blob are set along with the rest
+            if ((i << 3) + bit >= this->ArtNetConfigSize) break;
+            if (count == 0) return;
+            --count;
+            // A byte may have been changed back to its stored value, so update()
+            EEPROM.update(address + (i << 3) + bit, this->ArtNetConfigBlob[(i << 3) + bit]);
+            this->ArtNetConfigDirty[i] &= ~(1 << bit);
+        }
+    }
+    
+    if (slot != this->ArtNetConfigSlot) {
+        // Only now that the new blob is whole is the old one given up
+        address = this->configAddress(this->ArtNetConfigSlot);
+        if (EEPROM.read(address) == ARTNET_CONFIG_MAGIC) {
+            if (count == 0) return;
+            EEPROM.update(address, 0);
+        }
+        this->ArtNetConfigSlot = slot;
+    }
+    this->ArtNetConfigFlushing = 0;
+    this->ArtNetConfigPending = 0;
+}
+
+unsigned short ArtNetBase::GetPortAddress(unsigned short port)
+{
+    unsigned short page = port / ARTNET_PORTS;
+    if (port >= this->ArtNetPortCapacity) return 0;
+    return (*this->configNet(page) << 8) | ((*this->configSubnet(page) & 0x0f) << 4) | (this->ArtNetConfigInput[port] & 0x0f);
+}
+
+unsigned short ArtNetBase::GetOutputPortAddress(unsigned short port)
+{
+    unsigned short page = port / ARTNET_PORTS;
+    if (port >= this->ArtNetPortCapacity) return 0;
+    return (*this->configNet(page) << 8) | ((*this->configSubnet(page) & 0x0f) << 4) | (this->ArtNetConfigOutput[port] & 0x0f);
+}
+
+void ArtNetBase::SetMerge(unsigned short port, ArtNetMerge *merge)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    if (merge && !this->ArtNetPorts[port].merge) {
+        this->ArtNetMergePorts++;
+    } else if (!merge && this->ArtNetPorts[port].merge) {
+        this->ArtNetMergePorts--;
+    }
+    this->ArtNetPorts[port].merge = merge;
+}
+
+void ArtNetBase::SetSync(unsigned short port, ArtNetSyncBuffer *sync)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    this->ArtNetPorts[port].sync = sync;
+}
+
+void ArtNetBase::SetTransmit(unsigned short port, ArtNetTransmit *transmit)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    if (transmit && !this->ArtNetPorts[port].transmit) {
+        this->ArtNetTransmitPorts++;
+    } else if (!transmit && this->ArtNetPorts[port].transmit) {
+        this->ArtNetTransmitPorts--;
+    }
+    this->ArtNetPorts[port].transmit = transmit;
+    if (!transmit) {
+        this->setInputStatus(port, this->ArtNetPorts[port].inputStatus & ARTNET_GOOD_INPUT_DISABLED);
+    }
+}
+
+void ArtNetBase::SetChanges(unsigned short port, ArtNetChangeBuffer *changes)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    if (changes) {
+        changes->Clear();
+    }
+    this->ArtNetPorts[port].changes = changes;
+}
+
+void ArtNetBase::SetRdm(unsigned short port, ArtNetRdm *rdm)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    if (rdm && !this->ArtNetPorts[port].rdm) {
+        this->ArtNetRdmPorts++;
+    } else if (!rdm && this->ArtNetPorts[port].rdm) {
+        this->ArtNetRdmPorts--;
+    }
+    if (rdm) {
+        rdm->port = port;
+    }
+    this->ArtNetPorts[port].rdm = rdm;
+    // RDM capable whenever any port is
+    this->buildPollReply();
+}
+
+void ArtNetBase::SetTimecode(ArtNetTimecode *timecode)
+{
+    if (!timecode && this->ArtNetTimecodeClock) {
+        // Nothing would release frames staged for the next timecode frame
+        if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Arrive();
+        this->commitSync();
+    }
+    this->ArtNetTimecodeClock = timecode;
+}
+
+void ArtNetBase::SetReplica(unsigned char replica)
+{
+    this->ArtNetReplica = replica;
+}
+
+void ArtNetBase::SetSacn(ArtNetSacn *sacn)
+{
+    this->ArtNetSacnReceiver = sacn;
+}
+
+void ArtNetBase::SetRangeCallback(void (*rangeCallback)(unsigned short port, const char *buffer, unsigned short start, unsigned short length))
+{
+    this->rangeCallback = rangeCallback;
+}
+
+void ArtNetBase::AddPixelMap(ArtNetPixelMap *map)
+{
+    map->next = this->ArtNetPixelMaps;
+    this->ArtNetPixelMaps = map;
+}
+
+void ArtNetBase::AddPixelMap(ArtNetPixelMap *map, unsigned short port)
+{
+    if (port >= this->ArtNetPortCapacity) return;
+    // The strip starts at the port's universe and follows it when re-patched
+    map->port = port;
+    map->SetStart(this->GetPortAddress(port), map->startChannel);
+    this->AddPixelMap(map);
+}
+
+void ArtNetBase::rebuildDispatch()
+{
+    unsigned short i;
+    unsigned short slot;
+    unsigned short address;
+    
+    for (i = 0; i <= this->ArtNetDispatchMask; ++i) {
+        this->ArtNetDispatchAddress[i] = ARTNET_DISPATCH_EMPTY;
+    }
+    
+    this->ArtNetOutputExpected = 0;
+    this->ArtNetOutputDirtyPorts = 0;
+    for (i = 0; i < this->ArtNetPortCapacity; ++i) {
+        this->ArtNetPorts[i].expected = 0;
+    }
+    
+    // Insert in reverse so that each chain lists its ports in ascending order
+    for (i = this->Ports; i-- > 0; ) {
+        this->ArtNetPorts[i].dispatchNext = ARTNET_DISPATCH_END;
+        if (this->ArtNetConfigType[i] != ARTNET_IN) continue;
+        
+        // A frame is complete once every patched port has data
+        this->ArtNetPorts[i].expected = 1;
+        this->ArtNetOutputExpected++;
+        if (this->ArtNetPorts[i].dirty) this->ArtNetOutputDirtyPorts++;
+        
+        address = this->GetPortAddress(i);
+        slot = dispatchHash(address, this->ArtNetDispatchMask);
+        while (this->ArtNetDispatchAddress[slot] != ARTNET_DISPATCH_EMPTY &&
+               this->ArtNetDispatchAddress[slot] != address) {
+            slot = (slot + 1) & this->ArtNetDispatchMask;
+        }
+        if (this->ArtNetDispatchAddress[slot] == address) {
+            this->ArtNetPorts[i].dispatchNext = this->ArtNetDispatchPort[slot];
+        }
+        this->ArtNetDispatchAddress[slot] = address;
+        this->ArtNetDispatchPort[slot] = i;
+    }
+}
+
+unsigned short ArtNetBase::dispatchLookup(unsigned short address)
+{
+    unsigned short slot = dispatchHash(address, this->ArtNetDispatchMask);
+    
+    while (this->ArtNetDispatchAddress[slot] != ARTNET_DISPATCH_EMPTY) {
+        if (this->ArtNetDispatchAddress[slot] == address) {
+            return this->ArtNetDispatchPort[slot];
+        }
+        slot = (slot + 1) & this->ArtNetDispatchMask;
+    }
+    return ARTNET_DISPATCH_END;
+}
+
+unsigned int ArtNetBase::GetPacketCount()
 {
     return this->ArtNetInCounter;
 }
 
-unsigned int ArtNet::GetFailCount()
+unsigned int ArtNetBase::GetFailCount()
 {
     return this->ArtNetFailCounter;
 }
 
-void ArtNet::processPoll(byte ip[4], word port, const char *data, word len)
+unsigned int ArtNetBase::GetSkipCount()
+{
+    return this->ArtNetSkipCounter;
+}
+
+unsigned int ArtNetBase::GetSequenceDropCount()
+{
+    return this->ArtNetSequenceDropCounter;
+}
+
+unsigned int ArtNetBase::GetSequenceReorderCount()
+{
+    return this->ArtNetSequenceReorderCounter;
+}
+
+void ArtNetBase::processPoll(byte ip[4], word port, const char *data, word len)
 {
 	// Read data
 	data += sizeof(artnetheader_t) + sizeof(ArtNetMagic);
 	
-	memcpy(&this->serverIP, ip, 4);
+	// Nodes poll too (see sendArtPoll), asking for nothing unsolicited.  They
+	// are only answered, so they don't take over from the controller.
+	if ((data[0] & (ARTNET_DIAGNOSTIC_ALWAYS | ARTNET_DIAGNOSTIC_SEND)) && !this->fromSelf(ip)) {
+		memcpy(&this->serverIP, ip, 4);
 
-	this->ArtNetDiagnosticStatus = data[0];
-	this->ArtNetDiagnosticPriority = data[1];
+		this->ArtNetDiagnosticStatus = data[0];
+		this->ArtNetDiagnosticPriority = data[1];
 
-    this->SendPoll(1);
+		if (this->ArtNetDiscoveryTable) {
+			this->ArtNetDiscoveryTable->Poll(ip, data[0], data[1]);
+		}
+		this->diagnosticFilter();
+	}
+
+    this->sendPollReply(ip);
 }
 
-void ArtNet::processAddress(byte ip[4], word port, const char *data, word len)
+void ArtNetBase::processAddress(byte ip[4], word port, const char *data, word len)
 {
-	unsigned char i;
+	unsigned short i, page, base;
 	
 	// Read data
 	data += sizeof(artnetheader_t) + sizeof(ArtNetMagic);
 
+	// The bind index picks the page, 0 being the same as 1
+	page = data[1] ? (byte)data[1] - 1 : 0;
+	if (page >= this->ArtNetPages) {
+		return;
+	}
+	base = page * ARTNET_PORTS;
+
+	// Set the net
+	if (data[0] & (1 << 7)) {
+		unsigned char t;
+		t = data[0] & 0x7f;
+		this->configWrite(this->configNet(page), t);
+	}
+
 	// Set the short name
 	// Check if the name is null
     if (data[2]) {
     	// Let's set the short name
 	    for (i = 0; i < 18; ++i)
-	        EEPROM.write(this->eepromaddress + 1 + i, data[2 + i]);
+	        this->configWrite(&this->ArtNetConfig->shortName[i], data[2 + i]);
     }
 	
 	// Set the long name
 	// Check if the name is null
-    if (data[19]) {
-    	// Let's set the short name
-	    for (i = 0; i < 18; ++i)
-	        EEPROM.write(this->eepromaddress + 1 + 18 + i, data[2 + 18 + i]);
+    if (data[2 + 18]) {
+    	// Let's set the long name
+	    for (i = 0; i < 64; ++i)
+	        this->configWrite(&this->ArtNetConfig->longName[i], data[2 + 18 + i]);
+    }
+    
+    if (data[2] || data[2 + 18]) {
+        this->pollReplyNames();
     }
     
     // Set input universes
-    for (i = 0; i < MAX_PORTS; i++) {
+    for (i = 0; i < ARTNET_PORTS && base + i < this->ArtNetPortCapacity; i++) {
 		if (data[64 + 19 + 1 + i] != 0x7f && (data[64 + 19 + 1 + i] & (1 << 7))) {
 			unsigned char t;
 			// Only set if bit 7 is high
 			t = data[64 + 19 + 1 + i] & ~(1 << 7);
-			if (this->ArtNetInputUniverse[i] != t) {
-				this->ArtNetInputUniverse[i] = t;
-				EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 2 + i, t);
-			}
+			this->configWrite(&this->ArtNetConfigInput[base + i], t);
 		}
     }
     
     // Set output universes
-    for (i = 0; i < MAX_PORTS; i++) {
+    for (i = 0; i < ARTNET_PORTS && base + i < this->ArtNetPortCapacity; i++) {
 		if (data[64 + 19 + 1 + ARTNET_PORTS + i] != 0x7f && (data[64 + 19 + 1 + ARTNET_PORTS + i] & (1 << 7))) {
 			unsigned char t;
 			// Only set if bit 7 is high
 			t = data[64 + 19 + 1 + ARTNET_PORTS + i] & ~(1 << 7);
-			if (this->ArtNetOutputUniverse[i] != t) {
-				this->ArtNetOutputUniverse[i] = t;
-				EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + i, t);
-			}
+			this->configWrite(&this->ArtNetConfigOutput[base + i], t);
 		}
     }
     
@@ -332,98 +1032,632 @@ void ArtNet::processAddress(byte ip[4], word port, const char *data, word len)
 	if (data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS] != 0x7f && data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS] & (1 << 7)) {
 		unsigned char t;
 		t = data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS] & ~(1 << 7);
-		if (this->ArtNetSubnet != t) {
-			this->ArtNetSubnet = t;
-			EEPROM.write(this->eepromaddress + 1 + 18 + 64, t);
+		this->configWrite(this->configSubnet(page), t);
+	}
+	
+    // Command - merge commands only apply to ports with a merge attached
+	{
+		unsigned char command = data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS + 2];
+		unsigned short target = base + (command & 0x3);
+		ArtNetMerge *merge = target < this->ArtNetPortCapacity ? this->ArtNetPorts[target].merge : 0;
+		
+		switch (command) {
+			case 0x01:
+				// AcCancelMerge - the next source to send takes over
+				for (i = base; i < base + ARTNET_PORTS && i < this->ArtNetPortCapacity; i++) {
+					if (this->ArtNetPorts[i].merge) this->ArtNetPorts[i].merge->CancelMerge();
+				}
+				break;
+			case 0x10:
+			case 0x11:
+			case 0x12:
+			case 0x13:
+				// AcMergeLtp
+				if (merge) merge->SetMode(ARTNET_MERGE_LTP);
+				break;
+			case 0x50:
+			case 0x51:
+			case 0x52:
+			case 0x53:
+				// AcMergeHtp
+				if (merge) merge->SetMode(ARTNET_MERGE_HTP);
+				break;
+			case 0x90:
+			case 0x91:
+			case 0x92:
+			case 0x93:
+				// AcClearOp - reset data on the port
+				if (merge) {
+					const byte *cleared;
+					word length;
+					merge->Clear();
+					cleared = merge->GetOutput(&length);
+					this->outputPort(target, (const char*)cleared, length);
+				}
+				break;
+		}
+		
+		for (i = base; i < base + ARTNET_PORTS && i < this->ArtNetPortCapacity; i++) {
+			if (this->ArtNetPorts[i].merge) {
+				unsigned char status = this->ArtNetPorts[i].outputStatus & ~(ARTNET_GOOD_OUTPUT_LTP | ARTNET_GOOD_OUTPUT_MERGING);
+				if (this->ArtNetPorts[i].merge->GetMode() == ARTNET_MERGE_LTP) status |= ARTNET_GOOD_OUTPUT_LTP;
+				if (this->ArtNetPorts[i].merge->IsMerging()) status |= ARTNET_GOOD_OUTPUT_MERGING;
+				this->ArtNetPorts[i].outputStatus = status;
+			}
+		}
+	}
+	
+	this->patchChanged();
+	this->sendPollReply(ip);
+}
+
+unsigned char ArtNetBase::sequenceAccept(unsigned short port, byte ip[4], unsigned char sequence)
+{
+    unsigned char s;
+    unsigned char distance;
+    
+    for (s = 0; s < ARTNET_SEQUENCE_SOURCES; ++s) {
+        if (memcmp(this->ArtNetPorts[port].sequenceIp[s], ip, 4) == 0) break;
+    }
+    if (s == ARTNET_SEQUENCE_SOURCES) {
+        // New source, replace the oldest
+        s = this->ArtNetPorts[port].sequenceNext;
+        this->ArtNetPorts[port].sequenceNext = (s + 1) % ARTNET_SEQUENCE_SOURCES;
+        memcpy(this->ArtNetPorts[port].sequenceIp[s], ip, 4);
+        this->ArtNetPorts[port].sequenceLast[s] = sequence;
+        this->ArtNetPorts[port].sequenceStale[s] = 0;
+        return 1;
+    }
+    
+    if (sequence == 0 || this->ArtNetPorts[port].sequenceLast[s] == 0) {
+        // Sequence 0 means the sender doesn't use sequence numbers
+        this->ArtNetPorts[port].sequenceLast[s] = sequence;
+        return 1;
+    }
+    
+    // Sequences run 1 to 255 and wrap back to 1, so work modulo 255
+    distance = (sequence + 255 - this->ArtNetPorts[port].sequenceLast[s]) % 255;
+    if (distance == 0 || distance >= 128) {
+        this->ArtNetSequenceDropCounter++;
+        if (distance != 0) this->ArtNetSequenceReorderCounter++;
+        if (++this->ArtNetPorts[port].sequenceStale[s] < ARTNET_SEQUENCE_RESYNC) {
+            return 0;
+        }
+        // Too many in a row, the sender has most likely restarted
+    }
+    
+    this->ArtNetPorts[port].sequenceLast[s] = sequence;
+    this->ArtNetPorts[port].sequenceStale[s] = 0;
+    return 1;
+}
+
+void ArtNetBase::dispatchDmx(byte ip[4], byte physical, unsigned short address, const char *data, word length, unsigned short sequence)
+{
+    unsigned short i;
+    unsigned char patched;
+    
+    i = this->dispatchLookup(address);
+    patched = i != ARTNET_DISPATCH_END;
+    for (; i != ARTNET_DISPATCH_END; i = this->ArtNetPorts[i].dispatchNext) {
+        if (sequence == ARTNET_SEQUENCE_NONE || this->sequenceAccept(i, ip, sequence)) {
+            this->outputDmx(i, ip, physical, data, length);
+        } else if (this->ArtNetNodeMetrics) {
+            this->ArtNetNodeMetrics->Drop(ARTNET_DROP_SEQUENCE);
+        }
+    }
+    
+    // A patched universe reaches the pixel maps from outputPort(), once it
+    // has been sequenced, merged and synced
+    if (!patched) patched = this->outputPixels(address, data, length);
+    
+    if (!patched && this->ArtNetNodeMetrics) {
+        this->ArtNetNodeMetrics->Drop(ARTNET_DROP_UNPATCHED);
+    }
+}
+
+unsigned char ArtNetBase::outputPixels(unsigned short address, const char *data, word length)
+{
+    ArtNetPixelMap *map;
+    unsigned char written = 0;
+    
+    for (map = this->ArtNetPixelMaps; map; map = map->next) {
+        if (map->Write(address, (const byte*)data, length)) {
+            written = 1;
+            this->outputDirty(ARTNET_DIRTY_PIXELS);
+        }
+    }
+    return written;
+}
+
+void ArtNetBase::processSacn(byte ip[4], word port, const char *data, word len)
+{
+    ArtNetSacnFrame_t frame;
+    unsigned short address, i;
+    
+    if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Opcode(ARTNET_METRIC_SACN);
+    
+    switch (this->ArtNetSacnReceiver->Receive(data, len, &frame)) {
+        case ARTNET_SACN_DATA:
+            break;
+        case ARTNET_SACN_SYNC:
+            // Treated as an ArtSync, sync addresses aren't told apart
+            this->processSync(ip, port, data, len);
+            return;
+        case ARTNET_SACN_TERMINATED:
+            return;
+        case ARTNET_SACN_SEQUENCE:
+            if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_SEQUENCE);
+            return;
+        case ARTNET_SACN_PRIORITY:
+            if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_PRIORITY);
+            return;
+        default:
+            if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_SACN);
+            return;
+    }
+    
+    if (frame.universe - ARTNET_SACN_UNIVERSE_OFFSET > 0x7fff) {
+        // Beyond every Port-Address
+        if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_UNPATCHED);
+        return;
+    }
+    address = frame.universe - ARTNET_SACN_UNIVERSE_OFFSET;
+    
+    if (frame.overrides) {
+        // Lower priority sources are no longer merged in
+        for (i = this->dispatchLookup(address); i != ARTNET_DISPATCH_END; i = this->ArtNetPorts[i].dispatchNext) {
+            if (this->ArtNetPorts[i].merge) this->ArtNetPorts[i].merge->CancelMerge();
+        }
+    }
+    
+    // sACN has its own sequence numbers, already checked, and no physical
+    // port
+    this->dispatchDmx(ip, 0, address, frame.data, frame.length, ARTNET_SEQUENCE_NONE);
+}
+
+void ArtNetBase::outputDmx(unsigned short port, byte ip[4], byte physical, const char *data, word length)
+{
+    ArtNetMerge *merge = this->ArtNetPorts[port].merge;
+    unsigned char status = ARTNET_GOOD_OUTPUT_DATA;
+    
+    if (merge) {
+        data = (const char*)merge->Merge(ip, physical, (const byte*)data, length, &length);
+        if (!data) {
+            // A third source while already merging two
+            if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_MERGE);
+            return;
+        }
+        if (merge->IsMerging()) status |= ARTNET_GOOD_OUTPUT_MERGING;
+        if (merge->GetMode() == ARTNET_MERGE_LTP) status |= ARTNET_GOOD_OUTPUT_LTP;
+    }
+    this->setOutputStatus(port, status);
+    
+    if (this->ArtNetSyncActive && millis() - this->ArtNetSyncSeen > ARTNET_SYNC_TIMEOUT) {
+        // The controller stopped sending ArtSync, back to immediate mode.
+        // Frames still staged go out now rather than with whatever ArtSync
+        // comes next, unless they are held for the timecode.
+        this->ArtNetSyncActive = 0;
+        if (!(this->ArtNetTimecodeClock && this->ArtNetTimecodeClock->Locked())) {
+            this->commitSync();
+        }
+    }
+    
+    if ((this->ArtNetSyncActive || (this->ArtNetTimecodeClock && this->ArtNetTimecodeClock->Locked())) &&
+            this->ArtNetPorts[port].sync && !(merge && merge->IsMerging())) {
+        // Hold the frame until the ArtSync or timecode frame, merged ports
+        // ignore both
+        this->ArtNetPorts[port].sync->Stage((const byte*)data, length);
+        return;
+    }
+    
+    this->outputPort(port, data, length);
+}
+
+void ArtNetBase::outputPort(unsigned short port, const char *data, word length)
+{
+    ArtNetChangeBuffer *changes = this->ArtNetPorts[port].changes;
+    word start, end;
+    
+    if (this->ArtNetPixelMaps) {
+        // Before change detection, an unchanged universe still completes
+        // the strip's frame
+        this->outputPixels(this->GetPortAddress(port), data, length);
+    }
+    
+    if (!changes) {
+        this->callback(port, data, length);
+        if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Frame(port);
+        this->outputDirty(port);
+        return;
+    }
+    
+    start = changes->Next((const byte*)data, length, 0, &end);
+    if (start >= length) {
+        // Identical to the last frame, nothing to output or show
+        this->ArtNetSkipCounter++;
+        return;
+    }
+    
+    if (this->rangeCallback) {
+        do {
+            this->rangeCallback(port, data, start, end - start);
+            start = changes->Next((const byte*)data, length, end, &end);
+        } while (start < length);
+    } else {
+        while (changes->Next((const byte*)data, length, end, &end) < length);
+        this->callback(port, data, length);
+    }
+    if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Frame(port);
+    this->outputDirty(port);
+}
+
+void ArtNetBase::outputDirty(unsigned short port)
+{
+    ArtNetPort_t *state;
+    
+    if (!this->showFunc) return;
+    
+    if (!this->ArtNetOutputDirty) {
+        this->ArtNetShowDirtySince = millis();
+    }
+    this->ArtNetOutputDirty = 1;
+    
+    if (port == ARTNET_DIRTY_PIXELS) return;
+    state = &this->ArtNetPorts[port];
+    if (!state->dirty) {
+        state->dirty = 1;
+        if (state->expected) this->ArtNetOutputDirtyPorts++;
+    }
+}
+
+void ArtNetBase::clearDirty()
+{
+    unsigned short i;
+    
+    for (i = 0; i < this->ArtNetPortCapacity; ++i) {
+        this->ArtNetPorts[i].dirty = 0;
+    }
+    this->ArtNetOutputDirty = 0;
+    this->ArtNetOutputDirtyPorts = 0;
+}
+
+void ArtNetBase::processSync(byte ip[4], word port, const char *data, word len)
+{
+    this->ArtNetSyncActive = 1;
+    this->ArtNetSyncSeen = millis();
+    this->commitSync();
+}
+
+void ArtNetBase::commitSync()
+{
+    const byte *frame;
+    word length;
+    unsigned short i;
+    
+    // Commit every staged port together
+    for (i = 0; i < this->Ports; ++i) {
+        if (this->ArtNetPorts[i].sync && this->ArtNetPorts[i].sync->Pending()) {
+            frame = this->ArtNetPorts[i].sync->Swap(&length);
+            this->outputPort(i, (const char*)frame, length);
+        }
+    }
+}
+
+void ArtNetBase::setOutputStatus(unsigned short port, unsigned char status)
+{
+    if (this->ArtNetPorts[port].outputStatus != status) {
+        this->ArtNetPorts[port].outputStatus = status;
+        this->pollReplyPage(port / ARTNET_PORTS);
+    }
+}
+
+void ArtNetBase::setInputStatus(unsigned short port, unsigned char status)
+{
+    if (this->ArtNetPorts[port].inputStatus != status) {
+        this->ArtNetPorts[port].inputStatus = status;
+        this->pollReplyPage(port / ARTNET_PORTS);
+    }
+}
+
+void ArtNetBase::serviceTransmit()
+{
+    unsigned long now = millis();
+    byte subscribers[ARTNET_UNICAST_PEERS][4];
+    unsigned short n, port;
+    unsigned char i, count;
+    unsigned short address;
+    const byte *packet;
+    word length;
+    ArtNetTransmit *transmit;
+    
+    if (this->ArtNetDiscoveryTable && now - this->ArtNetTransmitPolled >= ARTNET_TRANSMIT_POLL) {
+        // Other nodes only reply to polls, so poll to learn the subscribers
+        this->ArtNetTransmitPolled = now;
+        this->sendArtPoll();
+    }
+    
+    if (now - this->ArtNetTransmitLast < ARTNET_TRANSMIT_SPACING) {
+        return;
+    }
+    
+    // At most one universe per call, starting after the last one sent, so
+    // that the universes are spread out rather than sent in a burst
+    for (n = 0; n < this->Ports; ++n) {
+        port = (this->ArtNetTransmitNext + n) % this->Ports;
+        transmit = this->ArtNetPorts[port].transmit;
+        if (!transmit || this->ArtNetConfigType[port] != ARTNET_OUT || this->ArtNetPorts[port].inputDisabled ||
+                !transmit->Due(now)) {
+            continue;
+        }
+        
+        address = this->GetOutputPortAddress(port);
+        packet = transmit->Send(now, address, port % ARTNET_PORTS, &length);
+        count = 0;
+        if (this->ArtNetDiscoveryTable) {
+            count = this->ArtNetDiscoveryTable->Subscribers(address, subscribers, ARTNET_UNICAST_PEERS);
+        }
+        if (count > 0 && count <= ARTNET_UNICAST_PEERS) {
+            for (i = 0; i < count; ++i) {
+                this->send(packet, length, UDP_PORT_ARTNET, subscribers[i], UDP_PORT_ARTNET);
+            }
+        } else {
+            this->send(packet, length, UDP_PORT_ARTNET, this->broadcastIP, UDP_PORT_ARTNET);
+        }
+        this->setInputStatus(port, ARTNET_GOOD_INPUT_DATA);
+        
+        this->ArtNetTransmitNext = port + 1;
+        this->ArtNetTransmitLast = now;
+        break;
+    }
+}
+
+void ArtNetBase::sendArtPoll()
+{
+    if (this->txLength < ARTNET_POLL_SIZE) {
+        return;
+    }
+    memcpy(this->txBuffer, ArtNetMagic, sizeof(ArtNetMagic));
+    this->txBuffer[8] = ARTNET_OP_POLL & 0xff;
+    this->txBuffer[9] = ARTNET_OP_POLL >> 8;
+    this->txBuffer[10] = 0;
+    this->txBuffer[11] = 14;
+    this->txBuffer[12] = 0;     // TalkToMe - only reply when polled, which
+                                // processPoll() takes to be from a node
+    this->txBuffer[13] = 0;     // Priority
+    this->send(this->txBuffer, ARTNET_POLL_SIZE, UDP_PORT_ARTNET, this->broadcastIP, UDP_PORT_ARTNET);
+}
+
+void ArtNetBase::processInput(byte ip[4], word port, const char *data, word len)
+{
+	// Read data
+	data += sizeof(artnetheader_t) + sizeof(ArtNetMagic);
+	unsigned short i, page, base;
+	unsigned char disabled;
+	ArtNetPort_t *state;
+	
+	// Routed by bind index, after the filler, as for ArtAddress
+	page = data[1] ? (byte)data[1] - 1 : 0;
+	if (page >= this->ArtNetPages) {
+		return;
+	}
+	base = page * ARTNET_PORTS;
+	
+	// Bit 0 of each port disables its input, the port type is left alone
+	for (i = 0; i < ARTNET_PORTS && base + i < this->ArtNetPortCapacity; i++) {
+		state = &this->ArtNetPorts[base + i];
+		disabled = data[4 + i] & 1;
+		if (state->inputDisabled != disabled) {
+			state->inputDisabled = disabled;
+			this->setInputStatus(base + i, disabled ? ARTNET_GOOD_INPUT_DISABLED : state->inputStatus & ~ARTNET_GOOD_INPUT_DISABLED);
 		}
 	}
+}
+
+void ArtNetBase::processRdm(byte ip[4], word port, const char *data, word len)
+{
+	const byte *packet = (const byte*)data;
+	unsigned short address, i;
+	
+	if (len < ARTNET_RDM_HEADER || packet[22] != 0) {
+		// Too short, or not ArProcess
+		return;
+	}
+	address = ((packet[21] & 0x7f) << 8) | packet[23];
 	
-    // Command - mostly ignored because we don't support any merging
-	switch (data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS + 2]) {
-		case 0x90:
-		case 0x91:
-		case 0x92: {
-			unsigned char t;
-			t = data[64 + 19 + 1 + ARTNET_PORTS + ARTNET_PORTS + 2] & 0x3;
-			// Reset data on port t
-			break;
+	// Every port on the Port-Address with RDM may have the device
+	for (i = this->dispatchLookup(address); i != ARTNET_DISPATCH_END; i = this->ArtNetPorts[i].dispatchNext) {
+		if (this->ArtNetPorts[i].rdm &&
+				!this->ArtNetPorts[i].rdm->Queue(ip, &packet[ARTNET_RDM_HEADER], len - ARTNET_RDM_HEADER) &&
+				this->ArtNetNodeMetrics) {
+			this->ArtNetNodeMetrics->Drop(ARTNET_DROP_RDM);
 		}
 	}
-	
-	this->SendPoll(1);
 }
 
-void ArtNet::processInput(byte ip[4], word port, const char *data, word len)
+void ArtNetBase::processTodRequest(byte ip[4], word port, const char *data, word len)
 {
-	// Read data
-	data += sizeof(artnetheader_t) + sizeof(ArtNetMagic);
-	unsigned char i;
+	const byte *packet = (const byte*)data;
+	unsigned char count, n;
+	unsigned short i;
 	
-	for (i = 0; i < MAX_PORTS; i++) {
-		if (this->ArtNetInputEnable[i] != (data[4 + i] & 1)) {
-			// Configure as input
-			if (this->ArtNetInputEnable[i] != (data[4 + i] & 1)) {
-				this->ArtNetInputEnable[i] = (data[4 + i] & 1) ? ARTNET_OUT : ARTNET_IN;
-				EEPROM.write(this->eepromaddress + 1 + 18 + 64 + MAX_PORTS + MAX_PORTS + i, this->ArtNetInputEnable[i]);
-			}
-			// Reconfigure port
-			if (data[4 + i] & 1) {
-			    // Port i - Input
-			} else {
-			    // Port i - Output
+	if (len < 24 || packet[22] != 0) {
+		// Too short, or not TodFull
+		return;
+	}
+	count = packet[23] < 32 ? packet[23] : 32;
+	if (len < 24 + count) {
+		count = len - 24;
+	}
+	
+	for (n = 0; n < count; ++n) {
+		i = this->dispatchLookup(((packet[21] & 0x7f) << 8) | packet[24 + n]);
+		for (; i != ARTNET_DISPATCH_END; i = this->ArtNetPorts[i].dispatchNext) {
+			if (this->ArtNetPorts[i].rdm) {
+				this->sendTod(i, ip);
 			}
 		}
 	}
 }
 
-void ArtNet::sendIPProgReply(byte ip[4], word port)
+void ArtNetBase::processTodControl(byte ip[4], word port, const char *data, word len)
+{
+	const byte *packet = (const byte*)data;
+	ArtNetRdm *rdm;
+	unsigned short i;
+	
+	if (len < 24) {
+		return;
+	}
+	
+	i = this->dispatchLookup(((packet[21] & 0x7f) << 8) | packet[23]);
+	for (; i != ARTNET_DISPATCH_END; i = this->ArtNetPorts[i].dispatchNext) {
+		rdm = this->ArtNetPorts[i].rdm;
+		if (!rdm) continue;
+		switch (packet[22]) {
+			case 0x01:
+				// AtcFlush - forget every device and discover again,
+				// serviceRdm() sends the new table once the pass is over
+				rdm->Flush();
+				break;
+			case 0x02:
+				// AtcEnd
+				rdm->EndDiscovery();
+				break;
+			case 0x03:
+				// AtcIncOn
+				rdm->SetIncremental(1);
+				break;
+			case 0x04:
+				// AtcIncOff
+				rdm->SetIncremental(0);
+				break;
+		}
+		this->sendTod(i, ip);
+	}
+}
+
+void ArtNetBase::serviceRdm()
+{
+    unsigned long now = millis();
+    byte dip[4];
+    unsigned short port;
+    const byte *packet;
+    word length;
+    ArtNetRdm *rdm;
+    
+    // Each port starts or checks on at most one transaction, nothing waits
+    for (port = 0; port < this->Ports; ++port) {
+        rdm = this->ArtNetPorts[port].rdm;
+        if (!rdm) continue;
+        
+        if (rdm->Service(now)) {
+            packet = rdm->Response(this->GetPortAddress(port), dip, &length);
+            this->send(packet, length, UDP_PORT_ARTNET, dip, UDP_PORT_ARTNET);
+        }
+        if (rdm->TodChanged()) {
+            this->sendTod(port, 0);
+        }
+    }
+}
+
+void ArtNetBase::serviceMerge()
+{
+    unsigned long now = millis();
+    unsigned char status;
+    unsigned short port;
+    ArtNetMerge *merge;
+    
+    // A source that stopped sending no longer shows as merging
+    for (port = 0; port < this->Ports; ++port) {
+        merge = this->ArtNetPorts[port].merge;
+        if (!merge || !merge->Service(now)) continue;
+        status = this->ArtNetPorts[port].outputStatus & ~ARTNET_GOOD_OUTPUT_MERGING;
+        if (merge->IsMerging()) status |= ARTNET_GOOD_OUTPUT_MERGING;
+        this->setOutputStatus(port, status);
+    }
+}
+
+void ArtNetBase::sendTod(unsigned short port, byte *dip)
+{
+    byte controllers[ARTNET_UNICAST_PEERS][4];
+    unsigned char count, i;
+    const byte *packet;
+    word length;
+    
+    packet = this->ArtNetPorts[port].rdm->Tod(this->GetPortAddress(port), port % ARTNET_PORTS + 1,
+                                              this->ArtNetPages > 1 ? port / ARTNET_PORTS + 1 : 0, &length);
+    if (dip) {
+        // Answering a controller
+        this->send(packet, length, UDP_PORT_ARTNET, dip, UDP_PORT_ARTNET);
+        return;
+    }
+    
+    // A change, tell every known controller if there aren't too many
+    count = 0;
+    if (this->ArtNetDiscoveryTable) {
+        count = this->ArtNetDiscoveryTable->Controllers(controllers, ARTNET_UNICAST_PEERS);
+    }
+    if (count > 0 && count <= ARTNET_UNICAST_PEERS) {
+        for (i = 0; i < count; ++i) {
+            this->send(packet, length, UDP_PORT_ARTNET, controllers[i], UDP_PORT_ARTNET);
+        }
+    } else {
+        this->send(packet, length, UDP_PORT_ARTNET, this->broadcastIP, UDP_PORT_ARTNET);
+    }
+}
+
+void ArtNetBase::sendIPProgReply(byte ip[4], word port)
 {
     size_t length = 0;
     unsigned short t16;
 
+    if (this->txLength < ARTNET_IP_PROG_REPLY_SIZE) {
+        return;
+    }
+
     // Magic
-    memcpy(this->buffer, ArtNetMagic, sizeof(ArtNetMagic));
+    memcpy(this->txBuffer, ArtNetMagic, sizeof(ArtNetMagic));
     length += sizeof(ArtNetMagic);
 
     // Op code
     t16 = htons(ARTNET_OP_IP_PROG_REPLY);
-    memcpy(&this->buffer[length], &t16, 2);
+    memcpy(&this->txBuffer[length], &t16, 2);
     length += 2;
 
     // Version
     t16 = htons(14);
-    memcpy(&this->buffer[length], &t16, 2);
+    memcpy(&this->txBuffer[length], &t16, 2);
     length += 2;
 
     // Padding
-    memset(&this->buffer[length], 0, 4);
+    memset(&this->txBuffer[length], 0, 4);
     length += 4;
 
     // Node IP
-    memcpy(&this->buffer[length], this->ip, 4);
+    memcpy(&this->txBuffer[length], this->ip, 4);
     length += 4;
     
     // Node subnet
-    memset(&this->buffer[length], 0, 4);
+    memset(&this->txBuffer[length], 0, 4);
     length += 4;
 
     // Port
     t16 = htons(UDP_PORT_ARTNET);
-    memcpy(&this->buffer[length], &t16, 2);
+    memcpy(&this->txBuffer[length], &t16, 2);
     length += 2;
     
     // Status (DHCP enabled?)
-    this->buffer[length++] = this->dhcp;
+    this->txBuffer[length++] = this->dhcp;
     
     // Spare/Filler
-    memset(&this->buffer[length], 0, 7);
+    memset(&this->txBuffer[length], 0, 7);
     length += 7;
 
     // Transmit ArtNetIpProgReply
-    this->sendFunc(length, UDP_PORT_ARTNET_REPLY, ip, port);
+    this->send(this->txBuffer, length, UDP_PORT_ARTNET_REPLY, ip, port);
 }
 
-void ArtNet::processIPProg(byte ip[4], word port, const char *data, word len)
+void ArtNetBase::processIPProg(byte ip[4], word port, const char *data, word len)
 {
     unsigned char i;
     IPConfiguration type;
@@ -465,31 +1699,57 @@ void ArtNet::processIPProg(byte ip[4], word port, const char *data, word len)
 	}
 	
 	// Set eeprom bit
-	EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 1, 1);
+	this->configWrite(&this->ArtNetConfigTail->ipChanged, 1);
 	for (i = 0; i < 4; ++i) {
-	    EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + MAX_PORTS + MAX_PORTS + i, ip[i]);
+	    this->configWrite(&this->ArtNetConfigTail->replyIp[i], ip[i]);
 	}
 	for (i = 0; i < 2; ++i) {
-	    EEPROM.write(this->eepromaddress + 1 + 18 + 64 + 2 + MAX_PORTS + MAX_PORTS + MAX_PORTS + 4 + i, ((byte*)&port)[i]);
+	    this->configWrite(&this->ArtNetConfigTail->replyPort[i], ((byte*)&port)[i]);
 	}
+	// The node is about to reboot so this can't wait for Service()
+	this->Commit();
 	// Save (and reboot)
 	this->setIP(type, newip, subnet);
 }
 
-void ArtNet::ProcessPacket(byte ip[4], word port, const char *data, word len)
+void ArtNetBase::ProcessPacket(byte ip[4], word port, const char *data, word len)
 {
-	artnetheader_t *header;
+	if (this->ArtNetNodeMetrics) {
+		// Latency is from the arrival of the batch, cost from each packet
+		if (this->ArtNetBatching) {
+			this->ArtNetNodeMetrics->Begin();
+		} else {
+			this->ArtNetNodeMetrics->Arrive();
+		}
+	}
 	
-	if (strncmp(data, ArtNetMagic, 7) != 0) {
+	if (strncmp(data, ArtNetMagic, 7) == 0) {
+		this->processArtNet(ip, port, data, len);
+		if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Processed(ARTNET_PROTOCOL_ARTNET);
+	} else if (this->ArtNetSacnReceiver && ArtNetSacnIs(data, len)) {
+		this->processSacn(ip, port, data, len);
+		if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Processed(ARTNET_PROTOCOL_SACN);
+	} else {
 		this->ArtNetFailCounter++;
-		return;
+		if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_MAGIC);
 	}
+}
+
+void ArtNetBase::processArtNet(byte ip[4], word port, const char *data, word len)
+{
+	artnetheader_t *header;
 	
 	this->ArtNetInCounter++;
 
 	header = (artnetheader_t*)(data + sizeof(ArtNetMagic));
+	
+	if (this->ArtNetNodeMetrics) {
+		this->ArtNetNodeMetrics->Opcode(metricOpcode(header->opcode));
+	}
     
-    if (header->protocol_lo < 14) {
+    // ArtPollReply has the IP address where other packets have the version
+    if (header->protocol_lo < 14 && header->opcode != ARTNET_OP_POLL_REPLY) {
+    	if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_PROTOCOL);
     	return;
     }
 
@@ -502,26 +1762,31 @@ void ArtNet::ProcessPacket(byte ip[4], word port, const char *data, word len)
     		break;
 		case ARTNET_OP_OUTPUT:
 			{
-				unsigned short universe, length;
-				unsigned char i;
+				unsigned short address, length;
+
+				if (len < sizeof(ArtNetMagic) + sizeof(artnetheader_t) + 6) {
+					if (this->ArtNetNodeMetrics) this->ArtNetNodeMetrics->Drop(ARTNET_DROP_SHORT);
+					break;
+				}
 
 				// Read data
 				data += sizeof(artnetheader_t) + sizeof(ArtNetMagic);
+				len -= sizeof(artnetheader_t) + sizeof(ArtNetMagic) + 6;
 	
-			    universe = data[2] | (data[3] << 8);
+				// Port-Address - 7 bit Net followed by SubNet and Universe
+			    address = ((data[3] & 0x7f) << 8) | (unsigned char)data[2];
     
 			    // Length
-			    length = htons(data[4]);
-    
-			    for (i = 0; i < this->Ports; i++) {
-			    	if (this->ArtNetInputUniverse[i] == universe && this->ArtNetInputEnable[i] == ARTNET_IN) {
-			    		// Set Data for this output
-			    		// Port i - d[6 + j] (j = 0 to length)
-			    		this->callback(i, &data[6], length);
-			    	}
-			    }
+			    length = ((unsigned char)data[4] << 8) | (unsigned char)data[5];
+			    if (length > len) length = len;
+			    if (length > ARTNET_DMX_LENGTH) length = ARTNET_DMX_LENGTH;
+    
+			    this->dispatchDmx(ip, data[1], address, &data[6], length, (unsigned char)data[0]);
 			}
 			break;
+		case ARTNET_OP_SYNC:
+			this->processSync(ip, port, data, len);
+			break;
 		case ARTNET_OP_ADDRESS:
 			this->processAddress(ip, port, data, len);
 			break;
@@ -539,34 +1804,48 @@ void ArtNet::ProcessPacket(byte ip[4], word port, const char *data, word len)
 		case ARTNET_OP_MAC_SLAVE:
 			break;
 
-		/* RDM - Currently unsupported */
+		/* RDM */
 
 		case ARTNET_OP_RDM:
+			this->processRdm(ip, port, data, len);
 			break;
 		case ARTNET_OP_RDM_SUB:
+			// Compressed sub-device requests are not supported
 			break;
 		case ARTNET_OP_TOD_REQUEST:
+			this->processTodRequest(ip, port, data, len);
 			break;
 		case ARTNET_OP_TOD_DATA:
+			// Only of interest to controllers
 			break;
 		case ARTNET_OP_TOD_CONTROL:
+			this->processTodControl(ip, port, data, len);
 			break;
 			
 		/* Ignored broadcasted reply op codes */
 		
 		case ARTNET_OP_POLL_REPLY:
-			// Ignore replies
+			// Only of interest when discovering peers, our own broadcast
+			// isn't one
+			if (this->ArtNetDiscoveryTable && !this->fromSelf(ip)) {
+				this->ArtNetDiscoveryTable->PollReply(ip, data, len);
+			}
+			break;
 		case ARTNET_OP_IP_PROG_REPLY:
 			// Ignore IP Programming replies
 		case ARTNET_OP_DIAG_DATA:
 			// Ignore diagnostics
 			break;
 			
-		/* Unsupported feature op codes */
-		
 		case ARTNET_OP_TIMECODE:
+			if (this->ArtNetTimecodeClock) {
+				this->ArtNetTimecodeClock->Receive((const byte*)data, len);
+			}
 			break;
 
+		/* Unsupported feature op codes */
+		
+
 		case ARTNET_OP_FIRMWARE_MASTER:
 		case ARTNET_OP_FIRMWARE_REPLY:
 			// Don't have the capability to do OTW firmware update
@@ -588,173 +1867,504 @@ void ArtNet::ProcessPacket(byte ip[4], word port, const char *data, word len)
 		/* Unknown op code */
 		
 		default:
-			ArtNetStatus = ARTNET_STATUS_PARSE_FAIL;
+			this->Diagnostic(ARTNET_DIAGNOSTIC_LOW, "Unknown op code", header->opcode);
+			this->setStatus(ARTNET_STATUS_PARSE_FAIL, ARTNET_STATUS_STRING_OK);
 			this->SendPoll(0);
 			return;
     }
 }
 
-void ArtNet::SendPoll(unsigned char force)
+void ArtNetBase::ProcessPackets(const ArtNetPacket_t *packets, unsigned short count)
 {
-    byte *destIp;
-    size_t length = 0;
-    unsigned int t16;
+    unsigned short i;
+    
+    this->ArtNetBatching = 1;
+    if (this->ArtNetNodeMetrics) {
+        // The whole batch arrived together, so time it from now
+        this->ArtNetNodeMetrics->Arrive();
+    }
+    for (i = 0; i < count; ++i) {
+        this->ProcessPacket((byte*)packets[i].ip, packets[i].port, packets[i].data, packets[i].length);
+    }
+    this->ArtNetBatching = 0;
+    this->flushSends();
+}
+
+void ArtNetBase::SetSendBatch(void (*sendBatch)(const ArtNetSend_t *sends, unsigned char count), ArtNetSend_t *queue, unsigned char size)
+{
+    this->flushSends();
+    this->sendBatch = sendBatch;
+    this->ArtNetSendQueue = queue;
+    this->ArtNetSendQueueSize = sendBatch ? size : 0;
+}
+
+void ArtNetBase::send(const byte *data, size_t length, word sport, byte *dip, word dport)
+{
+    ArtNetSend_t *queued;
+    unsigned char i;
+    
+    if (!this->ArtNetBatching || !this->ArtNetSendQueueSize) {
+        this->sendFunc(data, length, sport, dip, dport);
+        return;
+    }
+    
+    if (data == this->txBuffer) {
+        // The TX buffer is about to be reused, so anything still in it must go first
+        for (i = 0; i < this->ArtNetSendQueued; ++i) {
+            if (this->ArtNetSendQueue[i].data == this->txBuffer) {
+                this->flushSends();
+                break;
+            }
+        }
+    }
+    if (this->ArtNetSendQueued == this->ArtNetSendQueueSize) {
+        this->flushSends();
+    }
+    
+    queued = &this->ArtNetSendQueue[this->ArtNetSendQueued++];
+    queued->data = data;
+    queued->length = length;
+    queued->sport = sport;
+    memcpy(queued->ip, dip, 4);
+    queued->dport = dport;
+}
+
+void ArtNetBase::flushSends()
+{
+    if (this->ArtNetSendQueued) {
+        this->sendBatch(this->ArtNetSendQueue, this->ArtNetSendQueued);
+        this->ArtNetSendQueued = 0;
+    }
+}
 
+void ArtNetBase::SendPoll(unsigned char force)
+{
 	if (!force && !(this->ArtNetDiagnosticStatus & ARTNET_DIAGNOSTIC_ALWAYS)) {
 		// We are not forcing (i.e. not replying to ArtPoll) and not always sending updates
 		return;
 	}
 	
 	if (!force) {
-		// Increment the non-requested poll counter
-		this->ArtNetCounter++;
+		// Unsolicited replies are coalesced and rate limited by Service()
+		if (this->ArtNetPollPending) {
+			this->ArtNetPollSuppressed++;
+			this->ArtNetReportDirty = 1;
+		}
+		this->ArtNetPollPending = 1;
+		return;
 	}
 
-	if (this->ArtNetDiagnosticStatus & ARTNET_DIAGNOSTIC_BROADCAST) {
-		destIp = this->broadcastIP;
-	} else {
-		destIp = this->serverIP;
-	}
+	this->sendPollReply(0);
+}
+
+void ArtNetBase::SetDiscovery(ArtNetDiscovery *discovery)
+{
+    this->ArtNetDiscoveryTable = discovery;
+    this->diagnosticFilter();
+}
+
+void ArtNetBase::SetMetrics(ArtNetMetricsBase *metrics)
+{
+    this->ArtNetNodeMetrics = metrics;
+}
+
+void ArtNetBase::SetDiagnostics(ArtNetDiagnostics *diagnostics)
+{
+    this->ArtNetDiag = diagnostics;
+}
+
+unsigned char ArtNetBase::Diagnostic(byte priority, const char *text)
+{
+    if (!this->ArtNetDiag || !this->ArtNetDiagnosticWanted || priority < this->ArtNetDiagnosticFloor) {
+        return 0;
+    }
+    return this->ArtNetDiag->Queue(priority, text, 0, 0);
+}
+
+unsigned char ArtNetBase::Diagnostic(byte priority, const char *text, long value)
+{
+    if (!this->ArtNetDiag || !this->ArtNetDiagnosticWanted || priority < this->ArtNetDiagnosticFloor) {
+        return 0;
+    }
+    return this->ArtNetDiag->Queue(priority, text, value, 1);
+}
+
+void ArtNetBase::diagnosticFilter()
+{
+    const ArtNetPeer_t *peer;
+    unsigned char i;
+    
+    if (!this->ArtNetDiscoveryTable) {
+        // Only the last controller to poll counts
+        this->ArtNetDiagnosticWanted = (this->ArtNetDiagnosticStatus & ARTNET_DIAGNOSTIC_SEND) != 0;
+        this->ArtNetDiagnosticFloor = this->ArtNetDiagnosticPriority;
+        return;
+    }
+    
+    // Every known controller, so the filter is only ever too permissive
+    // until one that wanted diagnostics expires
+    this->ArtNetDiagnosticWanted = 0;
+    this->ArtNetDiagnosticFloor = ARTNET_DIAGNOSTIC_VOLATILE;
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        peer = this->ArtNetDiscoveryTable->Get(i);
+        if (peer && (peer->flags & ARTNET_PEER_CONTROLLER) && (peer->talkToMe & ARTNET_DIAGNOSTIC_SEND)) {
+            this->ArtNetDiagnosticWanted = 1;
+            if (peer->priority < this->ArtNetDiagnosticFloor) {
+                this->ArtNetDiagnosticFloor = peer->priority;
+            }
+        }
+    }
+}
+
+void ArtNetBase::serviceDiagnostics()
+{
+    const byte *packets[ARTNET_DIAG_BURST];
+    word lengths[ARTNET_DIAG_BURST];
+    byte priorities[ARTNET_DIAG_BURST];
+    unsigned char count, i;
+    
+    count = this->ArtNetDiag->Build(millis(), packets, lengths, priorities);
+    for (i = 0; i < count; ++i) {
+        this->sendDiagnostic(packets[i], lengths[i], priorities[i]);
+    }
+}
+
+void ArtNetBase::sendDiagnostic(const byte *packet, word length, byte priority)
+{
+    byte targets[ARTNET_UNICAST_PEERS][4];
+    const ArtNetPeer_t *peer;
+    unsigned char count = 0, broadcast = 0, i;
+    
+    if (!this->ArtNetDiscoveryTable) {
+        // Broadcast until a controller has polled
+        if ((this->ArtNetDiagnosticStatus & ARTNET_DIAGNOSTIC_UNICAST) && this->serverIP[0]) {
+            this->send(packet, length, UDP_PORT_ARTNET, this->serverIP, UDP_PORT_ARTNET);
+        } else {
+            this->send(packet, length, UDP_PORT_ARTNET, this->broadcastIP, UDP_PORT_ARTNET);
+        }
+        return;
+    }
+    
+    // Each controller that wants this priority, broadcast if any of them
+    // asked for that or there are too many to unicast to
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS && !broadcast; ++i) {
+        peer = this->ArtNetDiscoveryTable->Get(i);
+        if (!peer || !(peer->flags & ARTNET_PEER_CONTROLLER)) continue;
+        if (!(peer->talkToMe & ARTNET_DIAGNOSTIC_SEND) || priority < peer->priority) continue;
+        if (!(peer->talkToMe & ARTNET_DIAGNOSTIC_UNICAST) || count == ARTNET_UNICAST_PEERS) {
+            broadcast = 1;
+        } else {
+            memcpy(targets[count++], peer->ip, 4);
+        }
+    }
+    
+    if (broadcast) {
+        this->send(packet, length, UDP_PORT_ARTNET, this->broadcastIP, UDP_PORT_ARTNET);
+        return;
+    }
+    for (i = 0; i < count; ++i) {
+        this->send(packet, length, UDP_PORT_ARTNET, targets[i], UDP_PORT_ARTNET);
+    }
+}
+
+void ArtNetBase::SetPollLimit(unsigned char burst, unsigned int period)
+{
+    ArtNetBucketSet(&this->ArtNetPollBucket, burst, period, millis());
+}
+
+unsigned int ArtNetBase::GetPollSuppressedCount()
+{
+    return this->ArtNetPollSuppressed;
+}
+
+void ArtNetBase::servicePoll()
+{
+    if (!ArtNetBucketTake(&this->ArtNetPollBucket, millis(), 1)) {
+        return;
+    }
+    
+    // Increment the non-requested poll counter
+    this->ArtNetCounter++;
+    this->ArtNetReportDirty = 1;
+    this->sendPollReply(0);
+}
+
+void ArtNetBase::sendPollReply(byte *poller)
+{
+    byte controllers[ARTNET_UNICAST_PEERS][4];
+    byte *dip;
+    unsigned char count = 0, i, batching;
+    unsigned short page;
+    const byte *reply;
+
+    if (this->ArtNetReplica) {
+        // The node it copies answers for both
+        this->ArtNetPollPending = 0;
+        return;
+    }
+
+    if (this->ArtNetReportDirty) {
+        this->pollReplyReport();
+    }
+
+    if (this->ArtNetDiscoveryTable && poller) {
+        // Only the poller asked, which may be a node rather than the
+        // controller in serverIP
+        dip = poller;
+    } else if (this->ArtNetDiscoveryTable) {
+        // Tell every known controller of the change, if there aren't too many
+        count = this->ArtNetDiscoveryTable->Controllers(controllers, ARTNET_UNICAST_PEERS);
+        if (count > ARTNET_UNICAST_PEERS) count = 0;
+        dip = this->broadcastIP;
+    } else {
+        // TalkToMe only picks unicast for diagnostics, replies are broadcast
+        dip = this->broadcastIP;
+    }
+
+    // Every page is queued before any is sent, so a send batch takes them
+    // in as few calls as its queue allows
+    batching = this->ArtNetBatching;
+    this->ArtNetBatching = 1;
+    for (page = 0; page < this->ArtNetPages; ++page) {
+        reply = this->ArtNetPollReply + page * ARTNET_POLL_REPLY_SIZE;
+        if (count) {
+            for (i = 0; i < count; ++i) {
+                this->send(reply, ARTNET_POLL_REPLY_SIZE, UDP_PORT_ARTNET, controllers[i], UDP_PORT_ARTNET_REPLY);
+            }
+        } else {
+            this->send(reply, ARTNET_POLL_REPLY_SIZE, UDP_PORT_ARTNET, dip, UDP_PORT_ARTNET_REPLY);
+        }
+    }
+    this->ArtNetBatching = batching;
+    if (!batching) {
+        this->flushSends();
+    }
+    // Any pending unsolicited reply is covered by this one
+    this->ArtNetPollPending = 0;
+
+    // Reset status
+    this->setStatus(ARTNET_STATUS_POWER_OK, ARTNET_STATUS_STRING_OK);
+}
+
+void ArtNetBase::patchChanged()
+{
+    ArtNetPixelMap *map;
+    
+    for (map = this->ArtNetPixelMaps; map; map = map->next) {
+        if (map->port != ARTNET_PIXEL_NO_PORT && map->startAddress != this->GetPortAddress(map->port)) {
+            map->SetStart(this->GetPortAddress(map->port), map->startChannel);
+        }
+    }
+    this->rebuildDispatch();
+    this->pollReplyPorts();
+}
+
+void ArtNetBase::setStatus(ArtNetStatus_t status, char *statusString)
+{
+    if (this->ArtNetStatus != status || this->ArtNetStatusString != statusString) {
+        this->ArtNetStatus = status;
+        this->ArtNetStatusString = statusString;
+        this->ArtNetReportDirty = 1;
+    }
+}
+
+void ArtNetBase::buildPollReply()
+{
+    byte *reply = this->ArtNetPollReply;
+    unsigned short t16;
+    unsigned short page;
+
+    memset(reply, 0, ARTNET_POLL_REPLY_SIZE);
 
     // Magic
-    memcpy(&this->buffer[length], ArtNetMagic, sizeof(ArtNetMagic));
-    length += sizeof(ArtNetMagic);
+    memcpy(reply, ArtNetMagic, sizeof(ArtNetMagic));
     
     // Op code
-    t16 = ARTNET_OP_POLL_REPLY;
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
+    reply[ARTNET_REPLY_OPCODE] = ARTNET_OP_POLL_REPLY & 0xff;
+    reply[ARTNET_REPLY_OPCODE + 1] = ARTNET_OP_POLL_REPLY >> 8;
     
     // Transmit IP
-    memcpy(&this->buffer[length], this->ip, 4);
-    length += 4;
+    if (this->ip) {
+        memcpy(&reply[ARTNET_REPLY_IP], this->ip, 4);
+    }
     
     // Port
     t16 = UDP_PORT_ARTNET;
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
+    reply[ARTNET_REPLY_PORT] = t16 & 0xff;
+    reply[ARTNET_REPLY_PORT + 1] = t16 >> 8;
     
     // Version
-    t16 = htons(14);
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
-
-    // Subnet
-    t16 = htons(this->ArtNetSubnet);
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
+    reply[ARTNET_REPLY_VERSION] = 0;
+    reply[ARTNET_REPLY_VERSION + 1] = 14;
     
     // OEM
-    this->buffer[length++] = OEM_HI;
-    this->buffer[length++] = OEM_LO;
+    reply[ARTNET_REPLY_OEM] = OEM_HI;
+    reply[ARTNET_REPLY_OEM + 1] = OEM_LO;
     
     // UBEA
-    this->buffer[length++] = 0;
+    reply[ARTNET_REPLY_UBEA] = 0;
     
     // Status 1
-    this->buffer[length] = 0x3 << 6; // Indicators in Normal mode
-    this->buffer[length] = this->buffer[length] | (0x2 << 4); // Universe programmed by network
-    // t8 = t8 | (0x1 << 1); // RDM capable
-    ++length;
+    reply[ARTNET_REPLY_STATUS1] = 0x3 << 6; // Indicators in Normal mode
+    reply[ARTNET_REPLY_STATUS1] |= 0x2 << 4; // Universe programmed by network
+    if (this->ArtNetRdmPorts) {
+        reply[ARTNET_REPLY_STATUS1] |= 0x1 << 1; // RDM capable
+    }
     
     // ESTA (YD)
-    t16 = 0x5944;
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
+    reply[ARTNET_REPLY_ESTA] = 0x44;
+    reply[ARTNET_REPLY_ESTA + 1] = 0x59;
     
-    // Names
-    {
-        // Short name (18 bytes)
-        for (t16 = 0; t16 < 18; ++t16)
-            this->buffer[length++] = EEPROM.read(this->eepromaddress + 1 + t16);
-        // Long name (64 bytes)
-        for (t16 = 0; t16 < 64; ++t16)
-            this->buffer[length++] = EEPROM.read(this->eepromaddress + 1 + 18 + t16);
-    }
+    // Video, Macro and Remote followed by three spare and Style (StNode = 0)
+    // are left zeroed
+    
+    // MAC Address
+    memcpy(&reply[ARTNET_REPLY_MAC], this->mac, 6);
     
-    // Report
-    {
-        snprintf((char*)&this->buffer[length], 64, "#%x %d %s", this->ArtNetStatus, this->ArtNetCounter, this->ArtNetStatusString);
-        length += 64;
+    // Bind IP, set to the same as self IP
+    if (this->ip) {
+        memcpy(&reply[ARTNET_REPLY_BIND_IP], this->ip, 4);
     }
     
-    // Number of DMX ports
-    t16 = htons(this->Ports);
-    memcpy(&this->buffer[length], &t16, 2);
-    length += 2;
+    // Bind Index - Root node, so 0
+    reply[ARTNET_REPLY_BIND_INDEX] = 0;
     
-    // Port Configuration
-    // Port 1-4
-    for (t16 = 0; t16 < this->Ports; ++t16) {
-        this->buffer[length++] = 0xc0; // Input and output port over DMX512
-    }
-    for (; t16 < 4; ++t16) {
-        this->buffer[length++] = 0;
-    }
+    // Status 2
+    reply[ARTNET_REPLY_STATUS2] = 1; // Web browser configuration supported
+    reply[ARTNET_REPLY_STATUS2] |= (this->dhcp << 1); // DHCP is enabled
+    reply[ARTNET_REPLY_STATUS2] |= (1 << 2); // DHCP supported
     
-    // Port input status
-    for (t16 = 0; t16 < this->Ports; ++t16) {
-        this->buffer[length++] = ArtNetInputPortStatus[t16];
+    // Further pages are the same bar their bind index, counting from the
+    // root as 1, and their ports
+    if (this->ArtNetPages > 1) {
+        reply[ARTNET_REPLY_BIND_INDEX] = 1;
     }
-    for (; t16 < 4; ++t16) {
-        this->buffer[length++] = 0;
+    for (page = 1; page < this->ArtNetPages; ++page) {
+        memcpy(reply + page * ARTNET_POLL_REPLY_SIZE, reply, ARTNET_POLL_REPLY_SIZE);
+        reply[page * ARTNET_POLL_REPLY_SIZE + ARTNET_REPLY_BIND_INDEX] = page + 1;
     }
     
-    // Port output status
-    for (t16 = 0; t16 < this->Ports; ++t16) {
-        this->buffer[length++] = ArtNetOutputPortStatus[t16];
-    }
-    for (; t16 < 4; ++t16) {
-        this->buffer[length++] = 0;
+    this->pollReplyNames();
+    this->pollReplyPorts();
+    this->pollReplyReport();
+}
+
+void ArtNetBase::pollReplyNames()
+{
+    byte *reply;
+    unsigned short page;
+    unsigned char i;
+
+    for (page = 0; page < this->ArtNetPages; ++page) {
+        reply = this->ArtNetPollReply + page * ARTNET_POLL_REPLY_SIZE;
+        // Short name (18 bytes)
+        for (i = 0; i < 18; ++i)
+            reply[ARTNET_REPLY_SHORT_NAME + i] = this->ArtNetConfig->shortName[i];
+        // Long name (64 bytes)
+        for (i = 0; i < 64; ++i)
+            reply[ARTNET_REPLY_LONG_NAME + i] = this->ArtNetConfig->longName[i];
     }
-    
-    // Port input universe
-    for (t16 = 0; t16 < this->Ports; ++t16) {
-        this->buffer[length++] = ArtNetInputUniverse[t16];
+}
+
+void ArtNetBase::pollReplyPorts()
+{
+    unsigned short page;
+
+    for (page = 0; page < this->ArtNetPages; ++page) {
+        this->pollReplyPage(page);
     }
-    for (; t16 < 4; ++t16) {
-        this->buffer[length++] = 0;
+}
+
+void ArtNetBase::pollReplyPage(unsigned short page)
+{
+    byte *reply = this->ArtNetPollReply + page * ARTNET_POLL_REPLY_SIZE;
+    unsigned short base = page * ARTNET_PORTS;
+    unsigned char i, count;
+
+    if (page >= this->ArtNetPages) {
+        return;
     }
+
+    // Net and Subnet
+    reply[ARTNET_REPLY_NET] = *this->configNet(page);
+    reply[ARTNET_REPLY_SUBNET] = *this->configSubnet(page);
     
-    // Port output universe
-    for (t16 = 0; t16 < this->Ports; ++t16) {
-        this->buffer[length++] = ArtNetOutputUniverse[t16];
+    // Number of DMX ports, up to four on each page
+    count = this->Ports - base < ARTNET_PORTS ? this->Ports - base : ARTNET_PORTS;
+    reply[ARTNET_REPLY_NUM_PORTS] = 0;
+    reply[ARTNET_REPLY_NUM_PORTS + 1] = count;
+    
+    // Port configuration, status and universes, unused ports are zero
+    for (i = 0; i < ARTNET_PORTS; ++i) {
+        if (i < count) {
+            reply[ARTNET_REPLY_PORT_TYPES + i] = 0xc0; // Input and output port over DMX512
+            reply[ARTNET_REPLY_GOOD_INPUT + i] = this->ArtNetPorts[base + i].inputStatus;
+            reply[ARTNET_REPLY_GOOD_OUTPUT + i] = this->ArtNetPorts[base + i].outputStatus;
+            reply[ARTNET_REPLY_SW_IN + i] = this->ArtNetConfigInput[base + i];
+            reply[ARTNET_REPLY_SW_OUT + i] = this->ArtNetConfigOutput[base + i];
+        } else {
+            reply[ARTNET_REPLY_PORT_TYPES + i] = 0;
+            reply[ARTNET_REPLY_GOOD_INPUT + i] = 0;
+            reply[ARTNET_REPLY_GOOD_OUTPUT + i] = 0;
+            reply[ARTNET_REPLY_SW_IN + i] = 0;
+            reply[ARTNET_REPLY_SW_OUT + i] = 0;
+        }
     }
-    for (; t16 < 4; ++t16) {
-        this->buffer[length++] = 0;
+}
+
+static char *reportHex(char *out, unsigned short value)
+{
+    static const char digits[] = "0123456789abcdef";
+    out[0] = digits[(value >> 12) & 0xf];
+    out[1] = digits[(value >> 8) & 0xf];
+    out[2] = digits[(value >> 4) & 0xf];
+    out[3] = digits[value & 0xf];
+    return out + 4;
+}
+
+static char *reportDecimal(char *out, unsigned int value)
+{
+    unsigned char i;
+    // Four digits, wrapping as the spec allows
+    for (i = 4; i-- > 0; ) {
+        out[i] = '0' + (value % 10);
+        value /= 10;
     }
-    
-    // Video, Macro and Remote followed by three spare and Style (StNode = 0)
-    memset(&this->buffer[length], 0, 1 + 1 + 1 + 3 + 1);
-    length += 1 + 1 + 1 + 3 + 1;
-    
-    {
-        // MAC Address
-        memcpy(&this->buffer[length], this->mac, 6);
-        length += 6;
+    return out + 4;
+}
+
+void ArtNetBase::pollReplyReport()
+{
+    // "#xxxx [yyyy] zzzzz..." - status code, reply counter and status text
+    char *report = (char*)&this->ArtNetPollReply[ARTNET_REPLY_REPORT];
+    char *out = report;
+    unsigned short page;
+
+    *out++ = '#';
+    out = reportHex(out, this->ArtNetStatus);
+    *out++ = ' ';
+    *out++ = '[';
+    out = reportDecimal(out, this->ArtNetCounter);
+    *out++ = ']';
+    *out++ = ' ';
+    strncpy(out, this->ArtNetStatusString, 64 - (out - report));
+    // Always NULL terminated
+    report[63] = 0;
+
+    if (this->ArtNetPollSuppressed) {
+        // " (nnnn suppressed)" - unsolicited replies merged in to others
+        out = report + strlen(report);
+        if (out - report + 18 < 64) {
+            memcpy(out, " (", 2);
+            out = reportDecimal(out + 2, this->ArtNetPollSuppressed);
+            strcpy(out, " suppressed)");
+        }
     }
-    
-    // Bind IP, set to the same as self IP
-    memcpy(&this->buffer[length], this->ip, 4);
-    length += 4;
-    
-    // Bind Index - Root node, so 0
-    this->buffer[length++] = 0;
-    
-    // Status 2
-    this->buffer[length] = 1; // Web browser configuration supported
-    this->buffer[length] = this->buffer[length] | (this->dhcp << 1); // DHCP is enabled
-    this->buffer[length] = this->buffer[length] | (1 << 2); // DHCP supported
-    ++length;
-    
-    // Filler
-    memset(&this->buffer[length], 0, 26);
-    length += 26;
 
-    // Transmit ArtNetPollReply
-    this->sendFunc(length, UDP_PORT_ARTNET, destIp, UDP_PORT_ARTNET_REPLY);
+    // Every page reports the same
+    for (page = 1; page < this->ArtNetPages; ++page) {
+        memcpy(report + page * ARTNET_POLL_REPLY_SIZE, report, 64);
+    }
 
-    // Reset status
-    this->ArtNetStatus = ARTNET_STATUS_POWER_OK;
-    this->ArtNetStatusString = ARTNET_STATUS_STRING_OK;
+    this->ArtNetReportDirty = 0;
 }
@@ -22,10 +22,60 @@
 
 #include <Arduino.h>
 
-// The maximum number of ports supported
+// Ports of an ArtNet node, ArtNetNode<> can be sized for any number
 #define MAX_PORTS 4
 // The number of ports in a ArtNet packet
 #define ARTNET_PORTS 4
+// More ports are presented as pages of four, each with its own bind index
+#define ARTNET_PAGES(ports) (((ports) + ARTNET_PORTS - 1) / ARTNET_PORTS)
+// Maximum number of channels in a DMX universe
+#define ARTNET_DMX_LENGTH 512
+// Sources tracked per port for ArtDmx sequence numbers
+#define ARTNET_SEQUENCE_SOURCES 2
+// Consecutive stale frames after which a source is assumed to have restarted
+#define ARTNET_SEQUENCE_RESYNC 8
+// Size of an ArtPollReply on the wire
+#define ARTNET_POLL_REPLY_SIZE 239
+// Smallest TX buffer that holds every reply the node builds, the data given
+// to the send function is only valid until it returns
+#define ARTNET_TX_SIZE 34
+// Unsolicited ArtPollReply token bucket, burst replies then one a period (ms)
+#define ARTNET_POLL_BURST 2
+#define ARTNET_POLL_PERIOD 1000
+// Most peers a packet is unicast to, beyond this it is broadcast
+#define ARTNET_UNICAST_PEERS 4
+// Identifies the configuration blob in EEPROM, bump the version on layout changes
+#define ARTNET_CONFIG_MAGIC 0xa7
+#define ARTNET_CONFIG_VERSION 2
+// Milliseconds the configuration must be unchanged before Service() saves it
+#define ARTNET_COMMIT_DELAY 2000
+// Maximum EEPROM bytes written per call to Service()
+#define ARTNET_COMMIT_BYTES 1
+
+// Field offsets within an ArtPollReply
+#define ARTNET_REPLY_OPCODE      8
+#define ARTNET_REPLY_IP          10
+#define ARTNET_REPLY_PORT        14
+#define ARTNET_REPLY_VERSION     16
+#define ARTNET_REPLY_NET         18
+#define ARTNET_REPLY_SUBNET      19
+#define ARTNET_REPLY_OEM         20
+#define ARTNET_REPLY_UBEA        22
+#define ARTNET_REPLY_STATUS1     23
+#define ARTNET_REPLY_ESTA        24
+#define ARTNET_REPLY_SHORT_NAME  26
+#define ARTNET_REPLY_LONG_NAME   44
+#define ARTNET_REPLY_REPORT      108
+#define ARTNET_REPLY_NUM_PORTS   172
+#define ARTNET_REPLY_PORT_TYPES  174
+#define ARTNET_REPLY_GOOD_INPUT  178
+#define ARTNET_REPLY_GOOD_OUTPUT 182
+#define ARTNET_REPLY_SW_IN       186
+#define ARTNET_REPLY_SW_OUT      190
+#define ARTNET_REPLY_MAC         201
+#define ARTNET_REPLY_BIND_IP     207
+#define ARTNET_REPLY_BIND_INDEX  211
+#define ARTNET_REPLY_STATUS2     212
 
 // OEM_HI code taken from nomis52 ArtNet node
 #define OEM_HI 0x04
@@ -45,6 +95,17 @@ typedef enum ArtNetPortTypeTag {
 
 typedef enum { PRIMARY = 0, SECONDARY, DHCP, CUSTOM } IPConfiguration;
 
+// Diagnostic message priorities, a controller asks for those at or above one
+typedef enum ArtNetPriorityTag
+{
+	ARTNET_DIAGNOSTIC_LOW = 0x10,
+	ARTNET_DIAGNOSTIC_MED = 0x40,
+	ARTNET_DIAGNOSTIC_HIGH = 0x80,
+	ARTNET_DIAGNOSTIC_CRITICAL = 0xe0,
+	ARTNET_DIAGNOSTIC_VOLATILE = 0xff
+}
+ArtNetPriority;
+
 typedef enum ArtNetStatusTag
 {
 	ARTNET_STATUS_DEBUG = 0x0000,
@@ -65,8 +126,129 @@ typedef enum ArtNetStatusTag
 	ARTNET_STATIS_USER_FAIL = 0x000f
 } ArtNetStatus_t;
 
-class ArtNet
+// A received datagram, for ArtNet::ProcessPackets
+typedef struct ArtNetPacketTag
+{
+    byte ip[4];
+    word port;
+    const char *data;
+    word length;
+} ArtNetPacket_t;
+
+// A datagram to send, the data is only valid until the batch is sent
+typedef struct ArtNetSendTag
+{
+    const byte *data;
+    size_t length;
+    word sport;
+    byte ip[4];
+    word dport;
+} ArtNetSend_t;
+
+// Token bucket rate limit, up to burst at once then one a period (ms)
+typedef struct ArtNetBucketTag
+{
+    unsigned char burst;
+    unsigned char tokens;
+    unsigned int period;
+    unsigned long refill;
+} ArtNetBucket_t;
+
+void ArtNetBucketSet(ArtNetBucket_t *bucket, unsigned char burst, unsigned int period, unsigned long now);
+// Takes up to wanted tokens, returns how many were available
+unsigned char ArtNetBucketTake(ArtNetBucket_t *bucket, unsigned long now, unsigned char wanted);
+
+class ArtNetMerge;
+class ArtNetSyncBuffer;
+class ArtNetPixelMap;
+class ArtNetChangeBuffer;
+class ArtNetDiscovery;
+class ArtNetTransmit;
+class ArtNetMetricsBase;
+class ArtNetDiagnostics;
+class ArtNetRdm;
+class ArtNetTimecode;
+class ArtNetSacn;
+
+// Persistent node configuration, stored in EEPROM as a single blob of the
+// head, the input universes, output universes and types of every port, the
+// net and subnet of every page after the first, and the tail.  Only bytes are
+// used so that the layout is the same on every target, and a four port blob
+// is the same as before it was sized.  Where EEPROM has room for two blobs
+// they are written in turn, so one is whole whenever power is lost.
+typedef struct ArtNetConfigTag
+{
+    byte magic;
+    byte version;
+    char shortName[18];
+    char longName[64];
+    byte net;
+    byte subnet;
+} ArtNetConfig_t;
+
+typedef struct ArtNetConfigTailTag
+{
+    // Set when rebooting to apply an ArtIpProg, with who to reply to
+    byte ipChanged;
+    byte replyIp[4];
+    byte replyPort[2];
+    // CRC-16 (CCITT) of everything above, little endian
+    byte crc[2];
+} ArtNetConfigTail_t;
+
+#define ARTNET_CONFIG_SIZE(ports) (sizeof(ArtNetConfig_t) + 3 * (ports) + 2 * (ARTNET_PAGES(ports) - 1) + sizeof(ArtNetConfigTail_t))
+
+// Slots in the Port-Address dispatch table, a power of two at least twice
+// the number of ports
+constexpr unsigned int ArtNetDispatchSlots(unsigned int ports, unsigned int slots = 2)
 {
+    return slots >= 2 * ports ? slots : ArtNetDispatchSlots(ports, 2 * slots);
+}
+
+// Runtime state of a port
+typedef struct ArtNetPortTag
+{
+    unsigned char inputStatus;
+    unsigned char outputStatus;
+    // Input turned off by ArtInput, nothing is transmitted
+    unsigned char inputDisabled;
+    // Next port sharing the Port-Address in the dispatch table
+    unsigned short dispatchNext;
+    // Whether a show waits for the port, and if it has data for the show
+    unsigned char expected;
+    unsigned char dirty;
+    // Last applied ArtDmx sequence number per source
+    byte sequenceIp[ARTNET_SEQUENCE_SOURCES][4];
+    unsigned char sequenceLast[ARTNET_SEQUENCE_SOURCES];
+    unsigned char sequenceStale[ARTNET_SEQUENCE_SOURCES];
+    unsigned char sequenceNext;
+    // Optional merging, ArtSync staging, change detection, transmission and RDM
+    ArtNetMerge *merge;
+    ArtNetSyncBuffer *sync;
+    ArtNetChangeBuffer *changes;
+    ArtNetTransmit *transmit;
+    ArtNetRdm *rdm;
+} ArtNetPort_t;
+
+// Arrays sized by ArtNetNode<> for the node to use
+typedef struct ArtNetStorageTag
+{
+    unsigned short ports;
+    ArtNetPort_t *port;
+    unsigned short dispatchSlots;
+    unsigned short *dispatchAddress;
+    unsigned short *dispatchPort;
+    byte *config;
+    byte *configDirty;
+    byte *pollReply;
+} ArtNetStorage_t;
+
+// The node, for a number of ports chosen by ArtNetNode<>
+class ArtNetBase
+{
+  // Mirrors the output status of its workers into the control node
+  friend class ArtNetShards;
+
   private:
     byte *ip;
     byte *mac;
@@ -74,49 +256,250 @@ class ArtNet
     byte eepromaddress;
     byte broadcastIP[4];
     byte serverIP[4];
-    byte *buffer;
-    word buflen;
-    void (*sendFunc)(size_t length, word sport, byte *dip, word dport);
+    // Replies are built here, never in the buffer being received in to
+    byte *txBuffer;
+    word txLength;
+    void (*sendFunc)(const byte *data, size_t length, word sport, byte *dip, word dport);
+    // Optional batched sending, used while processing a batch or servicing
+    void (*sendBatch)(const ArtNetSend_t *sends, unsigned char count);
+    ArtNetSend_t *ArtNetSendQueue;
+    unsigned char ArtNetSendQueueSize;
+    unsigned char ArtNetSendQueued;
+    unsigned char ArtNetBatching;
+    unsigned char ArtNetReplica;
     void (*callback)(unsigned short, const char *, unsigned short);
+    void (*rangeCallback)(unsigned short, const char *, unsigned short, unsigned short);
     void (*setIP)(IPConfiguration, const char*, const char*);
     unsigned char ArtNetDiagnosticPriority;
     unsigned char ArtNetDiagnosticStatus;
+    // Optional ArtDiagData queue, and the lowest priority anyone wants
+    ArtNetDiagnostics *ArtNetDiag;
+    unsigned char ArtNetDiagnosticWanted;
+    unsigned char ArtNetDiagnosticFloor;
     unsigned int ArtNetCounter;
+    // Rate limiting of unsolicited ArtPollReply
+    unsigned char ArtNetPollPending;
+    ArtNetBucket_t ArtNetPollBucket;
+    unsigned int ArtNetPollSuppressed;
+    // Optional table of peers, replies are unicast to its controllers
+    ArtNetDiscovery *ArtNetDiscoveryTable;
     unsigned int ArtNetInCounter;
     unsigned int ArtNetFailCounter;
     ArtNetStatus_t ArtNetStatus;
     char *ArtNetStatusString;
-    unsigned char Ports;
-    unsigned char ArtNetInputPortStatus[MAX_PORTS];
-    unsigned char ArtNetOutputPortStatus[MAX_PORTS];
-    unsigned char ArtNetInputUniverse[MAX_PORTS];
-    unsigned char ArtNetOutputUniverse[MAX_PORTS];
-    ArtNetPortType ArtNetInputEnable[MAX_PORTS];
-    unsigned char ArtNetSubnet;
+    // Wire ready ArtPollReply per page, patched as the node state changes
+    byte *ArtNetPollReply;
+    unsigned short ArtNetPages;
+    unsigned char ArtNetReportDirty;
+    // Ports in use, and those there is storage for
+    unsigned short Ports;
+    unsigned short ArtNetPortCapacity;
+    ArtNetPort_t *ArtNetPorts;
+    // RAM copy of the EEPROM configuration and the bytes still to be saved
+    ArtNetConfig_t *ArtNetConfig;
+    byte *ArtNetConfigInput;
+    byte *ArtNetConfigOutput;
+    byte *ArtNetConfigType;
+    byte *ArtNetConfigPages;
+    ArtNetConfigTail_t *ArtNetConfigTail;
+    byte *ArtNetConfigBlob;
+    word ArtNetConfigSize;
+    byte *ArtNetConfigDirty;
+    unsigned char ArtNetConfigPending;
+    unsigned char ArtNetConfigCrcStale;
+    unsigned long ArtNetConfigChanged;
+    // Blobs that fit in EEPROM, the one last saved and whether the other
+    // is part written
+    unsigned char ArtNetConfigSlots;
+    unsigned char ArtNetConfigSlot;
+    unsigned char ArtNetConfigFlushing;
+    // Port-Address to port lookup, rebuilt whenever the patch changes
+    unsigned short *ArtNetDispatchAddress;
+    unsigned short *ArtNetDispatchPort;
+    unsigned short ArtNetDispatchMask;
+    unsigned int ArtNetSequenceDropCounter;
+    unsigned int ArtNetSequenceReorderCounter;
+    // Output scheduling, how many expected ports have data for the show
+    void (*showFunc)(void);
+    unsigned int ArtNetShowPeriod;
+    unsigned long ArtNetShowLast;
+    unsigned long ArtNetShowDirtySince;
+    unsigned char ArtNetOutputDirty;
+    unsigned short ArtNetOutputDirtyPorts;
+    unsigned short ArtNetOutputExpected;
+    unsigned char ArtNetSyncActive;
+    unsigned long ArtNetSyncSeen;
+    // Optional clock following ArtTimeCode, staged frames go out on its frames
+    ArtNetTimecode *ArtNetTimecodeClock;
+    // Optional sACN receiver, its data takes the same path as ArtDmx
+    ArtNetSacn *ArtNetSacnReceiver;
+    unsigned int ArtNetSkipCounter;
+    // Ports with a transmitter
+    unsigned short ArtNetTransmitPorts;
+    unsigned short ArtNetTransmitNext;
+    unsigned long ArtNetTransmitLast;
+    unsigned long ArtNetTransmitPolled;
+    // Ports with RDM
+    unsigned short ArtNetRdmPorts;
+    // Ports with a merge
+    unsigned short ArtNetMergePorts;
+    // LED strips fed directly from ArtDmx
+    ArtNetPixelMap *ArtNetPixelMaps;
+    // Optional detailed counters
+    ArtNetMetricsBase *ArtNetNodeMetrics;
+
+  protected:
+    ArtNetBase();
+    void begin(const ArtNetStorage_t *storage, byte *mac, byte eepromaddress, byte *txBuffer, word txLength, void (*setIP)(IPConfiguration, const char*, const char*), void (*sendFunc)(const byte*, size_t, word, byte*, word), void (*callback)(unsigned short, const char *, unsigned short), unsigned short ports);
 
   public:
-    ArtNet(byte *mac, byte eepromaddress, byte *buffer, word buflen, void (*setIP)(IPConfiguration, const char*, const char*), void (*sendFunc)(size_t, word, byte*, word), void (*callback)(unsigned short, const char *, unsigned short), unsigned char ports);
     void Configure(byte dhcp, byte *ip);
-    ArtNetPortType PortType(unsigned char port);
-    void PortType(unsigned char port, ArtNetPortType type);
+    unsigned short GetPorts();
+    unsigned short GetPages();
+    ArtNetPortType PortType(unsigned short port);
+    void PortType(unsigned short port, ArtNetPortType type);
+    // Set when an ArtInput disabled the port's input
+    unsigned char InputDisabled(unsigned short port);
     void ProcessPacket(byte ip[4], word port, const char *data, word len);
+    void ProcessPackets(const ArtNetPacket_t *packets, unsigned short count);
+    void SetSendBatch(void (*sendBatch)(const ArtNetSend_t *sends, unsigned char count), ArtNetSend_t *queue, unsigned char size);
+    void Service();
+    void Commit();
     void SendPoll(unsigned char force);
+    void SetPollLimit(unsigned char burst, unsigned int period);
+    void SetDiscovery(ArtNetDiscovery *discovery);
+    void SetMetrics(ArtNetMetricsBase *metrics);
+    void SetDiagnostics(ArtNetDiagnostics *diagnostics);
+    // Queues a diagnostic message, text must be a constant string.  Returns 0
+    // without touching the text if nobody wants the priority.
+    unsigned char Diagnostic(byte priority, const char *text);
+    unsigned char Diagnostic(byte priority, const char *text, long value);
     void GetLongName(char *longName);
     void SetLongName(char *longName);
     void GetShortName(char *shortName);
     void SetShortName(char *shortName);
-    unsigned char GetInputUniverse(unsigned char port);
-    void SetInputUniverse(unsigned char port, unsigned char universe);
+    unsigned char GetInputUniverse(unsigned short port);
+    void SetInputUniverse(unsigned short port, unsigned char universe);
+    unsigned char GetOutputUniverse(unsigned short port);
+    void SetOutputUniverse(unsigned short port, unsigned char universe);
     unsigned char GetSubnet();
     void SetSubnet(unsigned char subnet);
+    unsigned char GetNet();
+    void SetNet(unsigned char net);
+    unsigned char GetPageSubnet(unsigned short page);
+    void SetPageSubnet(unsigned short page, unsigned char subnet);
+    unsigned char GetPageNet(unsigned short page);
+    void SetPageNet(unsigned short page, unsigned char net);
+    unsigned short GetPortAddress(unsigned short port);
+    unsigned short GetOutputPortAddress(unsigned short port);
+    void SetShow(void (*show)(void), unsigned int period);
+    void SetMerge(unsigned short port, ArtNetMerge *merge);
+    void SetSync(unsigned short port, ArtNetSyncBuffer *sync);
+    void SetTransmit(unsigned short port, ArtNetTransmit *transmit);
+    void SetChanges(unsigned short port, ArtNetChangeBuffer *changes);
+    void SetRdm(unsigned short port, ArtNetRdm *rdm);
+    void SetTimecode(ArtNetTimecode *timecode);
+    void SetSacn(ArtNetSacn *sacn);
+    // A copy of another node, as the workers of ArtNetShards are.  It takes
+    // configuration but leaves storing it and answering polls to the other.
+    void SetReplica(unsigned char replica);
+    void SetRangeCallback(void (*rangeCallback)(unsigned short port, const char *buffer, unsigned short start, unsigned short length));
+    void AddPixelMap(ArtNetPixelMap *map);
+    void AddPixelMap(ArtNetPixelMap *map, unsigned short port);
     unsigned int GetPacketCount();
     unsigned int GetFailCount();
+    unsigned int GetSequenceDropCount();
+    unsigned int GetSequenceReorderCount();
+    unsigned int GetSkipCount();
+    unsigned int GetPollSuppressedCount();
   private:
+    void processArtNet(byte ip[4], word port, const char *data, word len);
+    void processSacn(byte ip[4], word port, const char *data, word len);
     void processPoll(byte ip[4], word port, const char *data, word len);
+    unsigned char fromSelf(const byte ip[4]);
     void processAddress(byte ip[4], word port, const char *data, word len);
     void processInput(byte ip[4], word port, const char *data, word len);
+    void processSync(byte ip[4], word port, const char *data, word len);
     void sendIPProgReply(byte ip[4], word port);
     void processIPProg(byte ip[4], word port, const char *data, word len);
+    void processRdm(byte ip[4], word port, const char *data, word len);
+    void processTodRequest(byte ip[4], word port, const char *data, word len);
+    void processTodControl(byte ip[4], word port, const char *data, word len);
+    void loadConfig(unsigned short ports);
+    unsigned char readConfig(unsigned char slot);
+    word configAddress(unsigned char slot);
+    void migrateConfig(unsigned short ports);
+    void defaultConfig(unsigned short ports);
+    void configWrite(byte *field, byte value);
+    void configWrite(char *field, byte value);
+    byte *configNet(unsigned short page);
+    byte *configSubnet(unsigned short page);
+    void flushConfig(word count);
+    void rebuildDispatch();
+    unsigned short dispatchLookup(unsigned short address);
+    unsigned char sequenceAccept(unsigned short port, byte ip[4], unsigned char sequence);
+    void dispatchDmx(byte ip[4], byte physical, unsigned short address, const char *data, word length, unsigned short sequence);
+    void outputDmx(unsigned short port, byte ip[4], byte physical, const char *data, word length);
+    void outputPort(unsigned short port, const char *data, word length);
+    unsigned char outputPixels(unsigned short address, const char *data, word length);
+    void outputDirty(unsigned short port);
+    void clearDirty();
+    void commitSync();
+    void serviceShow();
+    void servicePoll();
+    // To the poller, or NULL for an unsolicited reply
+    void sendPollReply(byte *poller);
+    void send(const byte *data, size_t length, word sport, byte *dip, word dport);
+    void flushSends();
+    void setOutputStatus(unsigned short port, unsigned char status);
+    void setInputStatus(unsigned short port, unsigned char status);
+    void serviceTransmit();
+    void sendArtPoll();
+    void serviceRdm();
+    void serviceMerge();
+    void sendTod(unsigned short port, byte *dip);
+    void diagnosticFilter();
+    void serviceDiagnostics();
+    void sendDiagnostic(const byte *packet, word length, byte priority);
+    void patchChanged();
+    void setStatus(ArtNetStatus_t status, char *statusString);
+    void buildPollReply();
+    void pollReplyNames();
+    void pollReplyPorts();
+    void pollReplyPage(unsigned short page);
+    void pollReplyReport();
 };
 
+// A node with storage for PortCount ports, of which the first ports are used
+template <unsigned short PortCount>
+class ArtNetNode : public ArtNetBase
+{
+  private:
+    ArtNetPort_t portState[PortCount];
+    unsigned short dispatchAddress[ArtNetDispatchSlots(PortCount)];
+    unsigned short dispatchPort[ArtNetDispatchSlots(PortCount)];
+    byte config[ARTNET_CONFIG_SIZE(PortCount)];
+    byte configDirty[(ARTNET_CONFIG_SIZE(PortCount) + 7) / 8];
+    byte pollReply[ARTNET_PAGES(PortCount)][ARTNET_POLL_REPLY_SIZE];
+
+  public:
+    ArtNetNode(byte *mac, byte eepromaddress, byte *txBuffer, word txLength, void (*setIP)(IPConfiguration, const char*, const char*), void (*sendFunc)(const byte*, size_t, word, byte*, word), void (*callback)(unsigned short, const char *, unsigned short), unsigned short ports = PortCount)
+    {
+        ArtNetStorage_t storage;
+
+        storage.ports = PortCount;
+        storage.port = this->portState;
+        storage.dispatchSlots = ArtNetDispatchSlots(PortCount);
+        storage.dispatchAddress = this->dispatchAddress;
+        storage.dispatchPort = this->dispatchPort;
+        storage.config = this->config;
+        storage.configDirty = this->configDirty;
+        storage.pollReply = this->pollReply[0];
+        this->begin(&storage, mac, eepromaddress, txBuffer, txLength, setIP, sendFunc, callback, ports);
+    }
+};
+
+// The original four port node
+typedef ArtNetNode<MAX_PORTS> ArtNet;
+
 #endif
@@ -0,0 +1,83 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetChange.h"
+#include <stdint.h>
+
+ArtNetChangeBuffer::ArtNetChangeBuffer()
+{
+    this->Clear();
+}
+
+void ArtNetChangeBuffer::Clear()
+{
+    memset(this->last, 0, sizeof(this->last));
+    this->length = 0;
+}
+
+word ArtNetChangeBuffer::skipSame(const byte *data, word length, word from)
+{
+    word i = from;
+    word same = length < this->length ? length : this->length;
+    uint32_t a, b;
+
+    // A word at a time through the (usually long) unchanged runs
+    while (i + 4 <= same) {
+        memcpy(&a, &data[i], 4);
+        memcpy(&b, &this->last[i], 4);
+        if (a != b) break;
+        i += 4;
+    }
+    while (i < same && data[i] == this->last[i]) {
+        i++;
+    }
+    return i;
+}
+
+word ArtNetChangeBuffer::Next(const byte *data, word length, word from, word *end)
+{
+    word i, j, gap;
+    // Only a universe is compared, but the end is reported against the
+    // caller's length so that its loop always finishes
+    word limit = length > ARTNET_DMX_LENGTH ? ARTNET_DMX_LENGTH : length;
+
+    i = this->skipSame(data, limit, from);
+    if (i >= limit) {
+        this->length = limit;
+        return length;
+    }
+
+    // Carry on until a long enough run of unchanged channels
+    j = i + 1;
+    gap = 0;
+    while (j < limit && gap < ARTNET_CHANGE_GAP) {
+        if (j >= this->length || data[j] != this->last[j]) {
+            gap = 0;
+        } else {
+            gap++;
+        }
+        j++;
+    }
+    j -= gap;
+
+    memcpy(&this->last[i], &data[i], j - i);
+    *end = j;
+    return i;
+}
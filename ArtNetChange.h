@@ -0,0 +1,52 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_CHANGE_H
+#define ARTNET_CHANGE_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Unchanged channels that split two changed ranges, shorter gaps are
+// reported as part of one range
+#define ARTNET_CHANGE_GAP 8
+
+// The last frame output on one port, so that a new frame can be reduced to
+// the channel ranges which changed.  Attach one to a port with
+// ArtNet::SetChanges, frames with no changes then skip the callback.
+class ArtNetChangeBuffer
+{
+  private:
+    byte last[ARTNET_DMX_LENGTH];
+    word length;
+
+  public:
+    ArtNetChangeBuffer();
+    // Returns the start of the first changed range at or after from and sets
+    // end to just past it, or returns length when nothing else changed.  The
+    // range is recorded as output.
+    word Next(const byte *data, word length, word from, word *end);
+    // The next frame is treated as entirely changed
+    void Clear();
+  private:
+    word skipSame(const byte *data, word length, word from);
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetDiagnostics.h"
+
+ArtNetDiagnostics::ArtNetDiagnostics()
+{
+    this->head = 0;
+    this->count = 0;
+    this->dropped = 0;
+    memset(this->packets, 0, sizeof(this->packets));
+    this->SetLimit(ARTNET_DIAG_BURST, ARTNET_DIAG_PERIOD);
+}
+
+void ArtNetDiagnostics::SetLimit(unsigned char burst, unsigned int period)
+{
+    if (burst > ARTNET_DIAG_BURST) burst = ARTNET_DIAG_BURST;
+    ArtNetBucketSet(&this->bucket, burst, period, millis());
+}
+
+unsigned char ArtNetDiagnostics::Queue(byte priority, const char *text, long value, byte hasValue)
+{
+    ArtNetDiagMessage_t *message;
+
+    if (this->count == ARTNET_DIAG_QUEUE) {
+        this->dropped++;
+        return 0;
+    }
+    message = &this->queue[(this->head + this->count) % ARTNET_DIAG_QUEUE];
+    message->priority = priority;
+    message->hasValue = hasValue;
+    message->text = text;
+    message->value = value;
+    this->count++;
+    return 1;
+}
+
+unsigned char ArtNetDiagnostics::Pending()
+{
+    return this->count;
+}
+
+unsigned int ArtNetDiagnostics::GetDropCount()
+{
+    return this->dropped;
+}
+
+word ArtNetDiagnostics::format(byte *packet, const ArtNetDiagMessage_t *message)
+{
+    char *text = (char*)&packet[ARTNET_DIAG_HEADER];
+    char digits[11];
+    unsigned long value;
+    word length = 0, d = 0;
+
+    // Leave room for a space, sign, ten digits and the terminator
+    while (message->text[length] && length < ARTNET_DIAG_TEXT - 14) {
+        text[length] = message->text[length];
+        ++length;
+    }
+    if (message->hasValue) {
+        text[length++] = ' ';
+        value = message->value;
+        if (message->value < 0) {
+            text[length++] = '-';
+            value = -value;
+        }
+        do {
+            digits[d++] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+        while (d) text[length++] = digits[--d];
+    }
+    text[length++] = '\0';
+
+    packet[13] = message->priority;
+    packet[16] = length >> 8;
+    packet[17] = length & 0xff;
+    return ARTNET_DIAG_HEADER + length;
+}
+
+unsigned char ArtNetDiagnostics::Build(unsigned long now, const byte *packets[], word lengths[], byte priorities[])
+{
+    unsigned char n, sent;
+    byte *packet;
+
+    if (!this->count) return 0;
+    sent = ArtNetBucketTake(&this->bucket, now, this->count);
+
+    for (n = 0; n < sent; ++n) {
+        packet = this->packets[n];
+        memcpy(packet, "Art-Net", 8);
+        // OpDiagData, protocol version 14
+        packet[8] = 0x00;
+        packet[9] = 0x23;
+        packet[10] = 0;
+        packet[11] = 14;
+        lengths[n] = this->format(packet, &this->queue[this->head]);
+        packets[n] = packet;
+        priorities[n] = this->queue[this->head].priority;
+        this->head = (this->head + 1) % ARTNET_DIAG_QUEUE;
+        this->count--;
+    }
+    return sent;
+}
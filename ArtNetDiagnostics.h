@@ -0,0 +1,76 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARTNET_DIAGNOSTICS_H
+#define ARTNET_DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Messages waiting to be sent
+#define ARTNET_DIAG_QUEUE 8
+// Most ArtDiagData sent by one call to Service(), each has its own buffer
+#define ARTNET_DIAG_BURST 2
+// Default rate, ARTNET_DIAG_BURST messages then one a period (ms)
+#define ARTNET_DIAG_PERIOD 100
+// Longest message text including the value and terminator
+#define ARTNET_DIAG_TEXT 64
+// Size of the ArtDiagData header before the text
+#define ARTNET_DIAG_HEADER 18
+
+typedef struct ArtNetDiagMessageTag
+{
+    byte priority;
+    byte hasValue;
+    // Not copied, so must be a constant string
+    const char *text;
+    long value;
+} ArtNetDiagMessage_t;
+
+// Queue of diagnostic messages for a node to send as ArtDiagData, attach
+// with ArtNet::SetDiagnostics.  Queueing only stores the text pointer and
+// value, the message is formatted when it is sent.
+class ArtNetDiagnostics
+{
+  private:
+    ArtNetDiagMessage_t queue[ARTNET_DIAG_QUEUE];
+    unsigned char head;
+    unsigned char count;
+    byte packets[ARTNET_DIAG_BURST][ARTNET_DIAG_HEADER + ARTNET_DIAG_TEXT];
+    ArtNetBucket_t bucket;
+    unsigned int dropped;
+
+  public:
+    ArtNetDiagnostics();
+    // Token bucket, up to ARTNET_DIAG_BURST messages then one a period (ms)
+    void SetLimit(unsigned char burst, unsigned int period);
+    // Returns 0 and counts a drop if the queue is full
+    unsigned char Queue(byte priority, const char *text, long value, byte hasValue);
+    // Formats as many queued messages as the rate allows in to ArtDiagData,
+    // the packets are valid until the next call.  Returns how many.
+    unsigned char Build(unsigned long now, const byte *packets[], word lengths[], byte priorities[]);
+    unsigned char Pending();
+    unsigned int GetDropCount();
+  private:
+    word format(byte *packet, const ArtNetDiagMessage_t *message);
+};
+
+#endif
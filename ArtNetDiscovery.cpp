@@ -0,0 +1,227 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetDiscovery.h"
+
+// Marks an unused hash slot
+#define ARTNET_DISCOVERY_EMPTY 0xff
+
+static inline unsigned char peerHash(const byte ip[4], byte bindIndex)
+{
+    return (ip[3] ^ (ip[2] << 1) ^ (bindIndex << 3)) & (ARTNET_DISCOVERY_SLOTS - 1);
+}
+
+ArtNetDiscovery::ArtNetDiscovery()
+{
+    memset(this->peers, 0, sizeof(this->peers));
+    memset(this->slots, ARTNET_DISCOVERY_EMPTY, sizeof(this->slots));
+    this->lastSweep = 0;
+}
+
+void ArtNetDiscovery::rebuild()
+{
+    unsigned char i, slot;
+
+    memset(this->slots, ARTNET_DISCOVERY_EMPTY, sizeof(this->slots));
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        if (this->peers[i].flags) {
+            slot = peerHash(this->peers[i].ip, this->peers[i].bindIndex);
+            while (this->slots[slot] != ARTNET_DISCOVERY_EMPTY) {
+                slot = (slot + 1) & (ARTNET_DISCOVERY_SLOTS - 1);
+            }
+            this->slots[slot] = i;
+        }
+    }
+}
+
+ArtNetPeer_t *ArtNetDiscovery::lookup(const byte ip[4], byte bindIndex, unsigned char create)
+{
+    unsigned char slot, i, oldest;
+    unsigned long age, oldestAge, now;
+    ArtNetPeer_t *peer;
+
+    slot = peerHash(ip, bindIndex);
+    while (this->slots[slot] != ARTNET_DISCOVERY_EMPTY) {
+        peer = &this->peers[this->slots[slot]];
+        if (peer->bindIndex == bindIndex && memcmp(peer->ip, ip, 4) == 0) {
+            return peer;
+        }
+        slot = (slot + 1) & (ARTNET_DISCOVERY_SLOTS - 1);
+    }
+    if (!create) return 0;
+
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        if (!this->peers[i].flags) break;
+    }
+    if (i == ARTNET_DISCOVERY_PEERS) {
+        // Full, replace whoever was heard from longest ago
+        now = millis();
+        oldest = 0;
+        oldestAge = 0;
+        for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+            peer = &this->peers[i];
+            age = now - (peer->flags & ARTNET_PEER_NODE ? peer->lastReply : peer->lastPoll);
+            if (age >= oldestAge) {
+                oldest = i;
+                oldestAge = age;
+            }
+        }
+        i = oldest;
+        this->peers[i].flags = 0;
+        this->rebuild();
+        slot = peerHash(ip, bindIndex);
+        while (this->slots[slot] != ARTNET_DISCOVERY_EMPTY) {
+            slot = (slot + 1) & (ARTNET_DISCOVERY_SLOTS - 1);
+        }
+    }
+
+    peer = &this->peers[i];
+    memset(peer, 0, sizeof(ArtNetPeer_t));
+    memcpy(peer->ip, ip, 4);
+    peer->bindIndex = bindIndex;
+    this->slots[slot] = i;
+    return peer;
+}
+
+void ArtNetDiscovery::PollReply(const byte ip[4], const char *data, word len)
+{
+    ArtNetPeer_t *peer;
+    byte bindIndex;
+
+    if (len < ARTNET_REPLY_SW_OUT + ARTNET_PORTS) {
+        return;
+    }
+    // Nodes before Art-Net 3 don't send a bind index, 0 and 1 are both the
+    // root device
+    bindIndex = len > ARTNET_REPLY_BIND_INDEX ? data[ARTNET_REPLY_BIND_INDEX] : 0;
+    if (bindIndex == ARTNET_PEER_CONTROLLER_INDEX) bindIndex = 1;
+
+    peer = this->lookup(ip, bindIndex, 1);
+    peer->flags |= ARTNET_PEER_NODE;
+    peer->lastReply = millis();
+    peer->net = data[ARTNET_REPLY_NET];
+    peer->subnet = data[ARTNET_REPLY_SUBNET];
+    peer->numPorts = data[ARTNET_REPLY_NUM_PORTS + 1];
+    memcpy(peer->portTypes, &data[ARTNET_REPLY_PORT_TYPES], ARTNET_PORTS);
+    memcpy(peer->swIn, &data[ARTNET_REPLY_SW_IN], ARTNET_PORTS);
+    memcpy(peer->swOut, &data[ARTNET_REPLY_SW_OUT], ARTNET_PORTS);
+    memcpy(peer->shortName, &data[ARTNET_REPLY_SHORT_NAME], 18);
+    peer->shortName[17] = 0;
+}
+
+void ArtNetDiscovery::Poll(const byte ip[4], byte talkToMe, byte priority)
+{
+    ArtNetPeer_t *peer = this->lookup(ip, ARTNET_PEER_CONTROLLER_INDEX, 1);
+
+    peer->flags |= ARTNET_PEER_CONTROLLER;
+    peer->lastPoll = millis();
+    peer->talkToMe = talkToMe;
+    peer->priority = priority;
+}
+
+void ArtNetDiscovery::Service(unsigned long now)
+{
+    unsigned char i, removed = 0;
+    ArtNetPeer_t *peer;
+
+    if (now - this->lastSweep < ARTNET_DISCOVERY_SWEEP) {
+        return;
+    }
+    this->lastSweep = now;
+
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        peer = &this->peers[i];
+        if ((peer->flags & ARTNET_PEER_NODE) && now - peer->lastReply >= ARTNET_DISCOVERY_TIMEOUT) {
+            peer->flags &= ~ARTNET_PEER_NODE;
+            removed |= !peer->flags;
+        }
+        if ((peer->flags & ARTNET_PEER_CONTROLLER) && now - peer->lastPoll >= ARTNET_DISCOVERY_TIMEOUT) {
+            peer->flags &= ~ARTNET_PEER_CONTROLLER;
+            removed |= !peer->flags;
+        }
+    }
+
+    if (removed) {
+        this->rebuild();
+    }
+}
+
+unsigned char ArtNetDiscovery::Controllers(byte ips[][4], unsigned char max)
+{
+    unsigned char i, count = 0;
+
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        if (this->peers[i].flags & ARTNET_PEER_CONTROLLER) {
+            if (count < max) {
+                memcpy(ips[count], this->peers[i].ip, 4);
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+unsigned char ArtNetDiscovery::Subscribers(unsigned short address, byte ips[][4], unsigned char max)
+{
+    unsigned char i, j, count = 0;
+    ArtNetPeer_t *peer;
+
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        peer = &this->peers[i];
+        if (!(peer->flags & ARTNET_PEER_NODE)) continue;
+        if ((address >> 8) != peer->net || ((address >> 4) & 0x0f) != (peer->subnet & 0x0f)) continue;
+        for (j = 0; j < peer->numPorts && j < ARTNET_PORTS; ++j) {
+            if ((peer->portTypes[j] & ARTNET_PEER_PORT_OUTPUT) && (peer->swOut[j] & 0x0f) == (address & 0x0f)) break;
+        }
+        if (j == peer->numPorts || j == ARTNET_PORTS) continue;
+
+        // One packet per IP, however many bind indexes it has
+        for (j = 0; j < count && j < max; ++j) {
+            if (memcmp(ips[j], peer->ip, 4) == 0) break;
+        }
+        if (j < count && j < max) continue;
+        if (count < max) {
+            memcpy(ips[count], peer->ip, 4);
+        }
+        count++;
+    }
+    return count;
+}
+
+const ArtNetPeer_t *ArtNetDiscovery::Find(const byte ip[4], byte bindIndex)
+{
+    return this->lookup(ip, bindIndex, 0);
+}
+
+unsigned char ArtNetDiscovery::Count()
+{
+    unsigned char i, count = 0;
+
+    for (i = 0; i < ARTNET_DISCOVERY_PEERS; ++i) {
+        if (this->peers[i].flags) count++;
+    }
+    return count;
+}
+
+const ArtNetPeer_t *ArtNetDiscovery::Get(unsigned char index)
+{
+    if (index >= ARTNET_DISCOVERY_PEERS || !this->peers[index].flags) return 0;
+    return &this->peers[index];
+}
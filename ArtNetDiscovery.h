@@ -0,0 +1,103 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_DISCOVERY_H
+#define ARTNET_DISCOVERY_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Peers (node bind indexes and controllers) held in the table
+#define ARTNET_DISCOVERY_PEERS 16
+// Hash slots indexing the table, a power of two above ARTNET_DISCOVERY_PEERS
+#define ARTNET_DISCOVERY_SLOTS 32
+// Milliseconds without an ArtPollReply (or ArtPoll) before a peer is dropped
+#define ARTNET_DISCOVERY_TIMEOUT 10000
+// Milliseconds between sweeps for expired peers
+#define ARTNET_DISCOVERY_SWEEP 1000
+
+// Roles of a peer, an IP that is both has an entry for each
+#define ARTNET_PEER_NODE       (1 << 0)
+#define ARTNET_PEER_CONTROLLER (1 << 1)
+
+// PortTypes bit of a port that can output from the network
+#define ARTNET_PEER_PORT_OUTPUT 0x80
+
+// ArtPoll carries no bind index, controllers are kept under this one.
+// Nodes number theirs from 1, an older node's 0 is taken as 1.
+#define ARTNET_PEER_CONTROLLER_INDEX 0
+
+typedef struct ArtNetPeerTag
+{
+    byte ip[4];
+    byte bindIndex;
+    byte flags;
+    // From the last ArtPoll, if a controller
+    byte talkToMe;
+    byte priority;
+    // From the last ArtPollReply, if a node
+    byte net;
+    byte subnet;
+    byte numPorts;
+    byte portTypes[ARTNET_PORTS];
+    byte swIn[ARTNET_PORTS];
+    byte swOut[ARTNET_PORTS];
+    char shortName[18];
+    unsigned long lastReply;
+    unsigned long lastPoll;
+} ArtNetPeer_t;
+
+// Table of the other nodes and controllers on the network, learnt from
+// ArtPoll and ArtPollReply.  Attach to a node with ArtNet::SetDiscovery and
+// its ArtPollReply will be unicast to the known controllers rather than
+// broadcast.
+class ArtNetDiscovery
+{
+  private:
+    ArtNetPeer_t peers[ARTNET_DISCOVERY_PEERS];
+    unsigned char slots[ARTNET_DISCOVERY_SLOTS];
+    unsigned long lastSweep;
+
+  public:
+    ArtNetDiscovery();
+    // Record an ArtPollReply, data is the whole packet
+    void PollReply(const byte ip[4], const char *data, word len);
+    // Record the sender of an ArtPoll as a controller
+    void Poll(const byte ip[4], byte talkToMe, byte priority);
+    // Drop peers not heard from, does nothing until a sweep is due
+    void Service(unsigned long now);
+    // Controllers currently polling, copies up to max IPs and returns the
+    // total which may be more than max
+    unsigned char Controllers(byte ips[][4], unsigned char max);
+    // Nodes with an output port patched to the Port-Address, copies up to
+    // max IPs and returns the total which may be more than max
+    unsigned char Subscribers(unsigned short address, byte ips[][4], unsigned char max);
+    // Returns NULL if the peer isn't known, ARTNET_PEER_CONTROLLER_INDEX
+    // finds a controller
+    const ArtNetPeer_t *Find(const byte ip[4], byte bindIndex);
+    unsigned char Count();
+    // Peers by table position, up to ARTNET_DISCOVERY_PEERS, NULL if unused
+    const ArtNetPeer_t *Get(unsigned char index);
+  private:
+    ArtNetPeer_t *lookup(const byte ip[4], byte bindIndex, unsigned char create);
+    void rebuild();
+};
+
+#endif
@@ -0,0 +1,235 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetMerge.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void ArtNetMergeHtp(byte *out, const byte *a, const byte *b, word length)
+{
+    word i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_max_epu8(va, vb));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16) {
+        vst1q_u8(out + i, vmaxq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+#endif
+    for (; i < length; ++i) {
+        out[i] = a[i] > b[i] ? a[i] : b[i];
+    }
+}
+
+void ArtNetMergeLtp(byte *out, const byte *data, const byte *previous, word length)
+{
+    word i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i vd = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i same = _mm_cmpeq_epi8(vd, _mm_loadu_si128((const __m128i*)(previous + i)));
+        __m128i vo = _mm_loadu_si128((const __m128i*)(out + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(_mm_and_si128(same, vo), _mm_andnot_si128(same, vd)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t vd = vld1q_u8(data + i);
+        vst1q_u8(out + i, vbslq_u8(vceqq_u8(vd, vld1q_u8(previous + i)), vld1q_u8(out + i), vd));
+    }
+#endif
+    for (; i < length; ++i) {
+        if (data[i] != previous[i]) out[i] = data[i];
+    }
+}
+
+ArtNetMerge::ArtNetMerge()
+{
+    this->mode = ARTNET_MERGE_HTP;
+    this->Clear();
+}
+
+void ArtNetMerge::Clear()
+{
+    unsigned char i;
+    for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+        this->sourceActive[i] = 0;
+        this->sourceLength[i] = 0;
+    }
+    // Sources are kept zero beyond their length so HTP can ignore lengths
+    memset(this->sourceData, 0, sizeof(this->sourceData));
+    memset(this->output, 0, sizeof(this->output));
+    this->current = this->output;
+    this->currentLength = ARTNET_DMX_LENGTH;
+    this->cancelPending = 0;
+}
+
+ArtNetMergeMode ArtNetMerge::GetMode()
+{
+    return this->mode;
+}
+
+void ArtNetMerge::SetMode(ArtNetMergeMode mode)
+{
+    this->mode = mode;
+}
+
+void ArtNetMerge::CancelMerge()
+{
+    this->cancelPending = 1;
+}
+
+unsigned char ArtNetMerge::IsMerging()
+{
+    unsigned char i, active = 0;
+    for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+        active += this->sourceActive[i];
+    }
+    return active > 1;
+}
+
+const byte *ArtNetMerge::GetOutput(word *outLength)
+{
+    *outLength = this->currentLength;
+    return this->current;
+}
+
+void ArtNetMerge::drop(unsigned char s)
+{
+    this->sourceActive[s] = 0;
+    memset(this->sourceData[s], 0, this->sourceLength[s]);
+    this->sourceLength[s] = 0;
+}
+
+unsigned char ArtNetMerge::Service(unsigned long now)
+{
+    unsigned char i, dropped = 0;
+    for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+        if (this->sourceActive[i] && now - this->sourceSeen[i] > ARTNET_MERGE_TIMEOUT) {
+            this->drop(i);
+            dropped = 1;
+        }
+    }
+    return dropped;
+}
+
+const byte *ArtNetMerge::Merge(const byte ip[4], byte physical, const byte *data, word length, word *outLength)
+{
+    unsigned long now = millis();
+    const byte *merged;
+    unsigned char s, i, fresh = 0, others = 0;
+
+    if (length > ARTNET_DMX_LENGTH) length = ARTNET_DMX_LENGTH;
+
+    this->Service(now);
+
+    // Find the source, or a free slot for a new one
+    for (s = 0; s < ARTNET_MERGE_SOURCES; ++s) {
+        if (this->sourceActive[s] && this->sourcePhysical[s] == physical &&
+                memcmp(this->sourceIp[s], ip, 4) == 0) break;
+    }
+    if (s == ARTNET_MERGE_SOURCES) {
+        for (s = 0; s < ARTNET_MERGE_SOURCES; ++s) {
+            if (!this->sourceActive[s]) break;
+        }
+        if (s == ARTNET_MERGE_SOURCES) {
+            if (!this->cancelPending) {
+                // Every slot is taken, another source is ignored
+                return 0;
+            }
+            // Taking over, the others are dropped below
+            s = 0;
+            this->drop(s);
+        }
+        memcpy(this->sourceIp[s], ip, 4);
+        this->sourcePhysical[s] = physical;
+        this->sourceActive[s] = 1;
+        fresh = 1;
+    }
+
+    if (this->cancelPending) {
+        // This source takes over the port
+        this->cancelPending = 0;
+        for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+            if (i != s && this->sourceActive[i]) this->drop(i);
+        }
+    }
+
+    for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+        if (i != s && this->sourceActive[i]) others++;
+    }
+
+    if (others && this->mode == ARTNET_MERGE_LTP) {
+        if (this->current != this->output) {
+            // Carry on from the single source that was being output
+            memcpy(this->output, this->current, ARTNET_DMX_LENGTH);
+        }
+        if (fresh) {
+            memcpy(this->output, data, length);
+        } else {
+            // Only the channels this source changed take precedence
+            ArtNetMergeLtp(this->output, data, this->sourceData[s], length);
+        }
+    }
+
+    memcpy(this->sourceData[s], data, length);
+    if (length < this->sourceLength[s]) {
+        memset(&this->sourceData[s][length], 0, this->sourceLength[s] - length);
+    }
+    this->sourceLength[s] = length;
+    this->sourceSeen[s] = now;
+
+    if (!others) {
+        // Single source
+        this->current = this->sourceData[s];
+        this->currentLength = length;
+    } else {
+        this->currentLength = 0;
+        for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+            if (this->sourceActive[i] && this->sourceLength[i] > this->currentLength) {
+                this->currentLength = this->sourceLength[i];
+            }
+        }
+        if (this->mode == ARTNET_MERGE_HTP) {
+            merged = 0;
+            for (i = 0; i < ARTNET_MERGE_SOURCES; ++i) {
+                if (!this->sourceActive[i]) continue;
+                if (merged) {
+                    ArtNetMergeHtp(this->output, merged, this->sourceData[i], this->currentLength);
+                    merged = this->output;
+                } else {
+                    merged = this->sourceData[i];
+                }
+            }
+        }
+        this->current = this->output;
+    }
+
+    *outLength = this->currentLength;
+    return this->current;
+}
@@ -0,0 +1,84 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_MERGE_H
+#define ARTNET_MERGE_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Milliseconds without data before a source is dropped from a merge
+#define ARTNET_MERGE_TIMEOUT 10000
+// Number of sources that can be merged on one port
+#define ARTNET_MERGE_SOURCES 2
+
+typedef enum ArtNetMergeModeTag {
+    ARTNET_MERGE_HTP,
+    ARTNET_MERGE_LTP
+} ArtNetMergeMode;
+
+// Per-channel maximum of two buffers, vectorised where the target allows
+void ArtNetMergeHtp(byte *out, const byte *a, const byte *b, word length);
+// Copies the channels of data that differ from previous in to out
+void ArtNetMergeLtp(byte *out, const byte *data, const byte *previous, word length);
+
+// Merges ArtDmx from up to ARTNET_MERGE_SOURCES sources for a single port.
+// HTP takes the highest level of each channel, LTP the level the most
+// recently changed it.  Attach one to each port that should merge with
+// ArtNet::SetMerge, ports without one pass every frame straight through to
+// the callback.
+class ArtNetMerge
+{
+  private:
+    byte sourceIp[ARTNET_MERGE_SOURCES][4];
+    byte sourcePhysical[ARTNET_MERGE_SOURCES];
+    byte sourceData[ARTNET_MERGE_SOURCES][ARTNET_DMX_LENGTH];
+    word sourceLength[ARTNET_MERGE_SOURCES];
+    unsigned long sourceSeen[ARTNET_MERGE_SOURCES];
+    unsigned char sourceActive[ARTNET_MERGE_SOURCES];
+    byte output[ARTNET_DMX_LENGTH];
+    const byte *current;
+    word currentLength;
+    ArtNetMergeMode mode;
+    unsigned char cancelPending;
+
+  public:
+    ArtNetMerge();
+    // Returns the frame to output, or NULL if the source was dropped as
+    // every slot is taken.  A source is an IP and the physical port of the
+    // node sending from it, so two ports of one node merge.
+    const byte *Merge(const byte ip[4], byte physical, const byte *data, word length, word *outLength);
+    // Drops sources that stopped sending, returns 1 if any were dropped.
+    // Called by the node's Service() so a port stops merging on its own.
+    unsigned char Service(unsigned long now);
+    ArtNetMergeMode GetMode();
+    void SetMode(ArtNetMergeMode mode);
+    // The next source to send data becomes the only source
+    void CancelMerge();
+    // Forget all sources and zero the output
+    void Clear();
+    unsigned char IsMerging();
+    // The frame most recently returned by Merge, or zeros after Clear
+    const byte *GetOutput(word *outLength);
+  private:
+    void drop(unsigned char s);
+};
+
+#endif
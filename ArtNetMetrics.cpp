@@ -0,0 +1,83 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetMetrics.h"
+
+void ArtNetMetricsBase::begin(unsigned long *frames, unsigned long *framesLast, unsigned int *frameRate, unsigned short ports)
+{
+    this->frames = frames;
+    this->framesLast = framesLast;
+    this->frameRate = frameRate;
+    this->ports = ports;
+    this->clock = micros;
+    this->Reset();
+}
+
+void ArtNetMetricsBase::SetClock(unsigned long (*clock)(void))
+{
+    this->clock = clock ? clock : micros;
+}
+
+void ArtNetMetricsBase::Reset()
+{
+    memset(&this->counts, 0, sizeof(this->counts));
+    memset(this->frames, 0, this->ports * sizeof(this->frames[0]));
+    memset(this->framesLast, 0, this->ports * sizeof(this->framesLast[0]));
+    memset(this->frameRate, 0, this->ports * sizeof(this->frameRate[0]));
+    this->arrival = this->start = this->clock();
+    this->lastRate = millis();
+}
+
+void ArtNetMetricsBase::Snapshot(ArtNetMetrics_t *out)
+{
+    memcpy(out, &this->counts, sizeof(this->counts));
+}
+
+void ArtNetMetricsBase::Frame(unsigned short port)
+{
+    unsigned long elapsed = this->clock() - this->arrival;
+    unsigned char bucket = 0;
+
+    if (port < this->ports) this->frames[port]++;
+
+    // Bucket by the number of bits in the latency
+#if defined(__GNUC__)
+    if (elapsed) bucket = sizeof(unsigned long) * 8 - __builtin_clzl(elapsed);
+#else
+    unsigned long range;
+    for (range = elapsed; range; range >>= 1) ++bucket;
+#endif
+    if (bucket > ARTNET_LATENCY_BUCKETS - 1) bucket = ARTNET_LATENCY_BUCKETS - 1;
+    this->counts.latency[bucket]++;
+    if (elapsed > this->counts.latencyMax) this->counts.latencyMax = elapsed;
+}
+
+void ArtNetMetricsBase::Service(unsigned long now)
+{
+    unsigned short i;
+
+    if (now - this->lastRate < ARTNET_METRICS_PERIOD) return;
+    this->lastRate = now;
+    for (i = 0; i < this->ports; ++i) {
+        this->frameRate[i] = this->frames[i] - this->framesLast[i];
+        this->framesLast[i] = this->frames[i];
+    }
+}
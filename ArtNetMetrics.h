@@ -0,0 +1,188 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_METRICS_H
+#define ARTNET_METRICS_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Latency histogram buckets, bucket n counts latencies under 2^n clock ticks
+// and the last bucket everything longer
+#define ARTNET_LATENCY_BUCKETS 16
+// Milliseconds over which the port frame rates are measured
+#define ARTNET_METRICS_PERIOD 1000
+
+// Received op codes, grouped
+typedef enum ArtNetMetricOpcodeTag
+{
+    ARTNET_METRIC_POLL,
+    ARTNET_METRIC_POLL_REPLY,
+    ARTNET_METRIC_DMX,
+    ARTNET_METRIC_SYNC,
+    ARTNET_METRIC_ADDRESS,
+    ARTNET_METRIC_INPUT,
+    ARTNET_METRIC_IP_PROG,
+    ARTNET_METRIC_DIAG,
+    ARTNET_METRIC_RDM,
+    ARTNET_METRIC_TIMECODE,
+    ARTNET_METRIC_OTHER,
+    // Every sACN packet, whatever it carries
+    ARTNET_METRIC_SACN,
+    ARTNET_METRIC_OPCODES
+} ArtNetMetricOpcode;
+
+// Why a packet (or an ArtDmx frame for one port) was dropped
+typedef enum ArtNetDropReasonTag
+{
+    // Neither Art-Net nor, with an ArtNetSacn attached, sACN
+    ARTNET_DROP_MAGIC,
+    // Protocol version older than 14
+    ARTNET_DROP_PROTOCOL,
+    // ArtDmx too short for its header
+    ARTNET_DROP_SHORT,
+    // ArtDmx for a Port-Address no port or pixel map is patched to
+    ARTNET_DROP_UNPATCHED,
+    // ArtDmx repeated or out of order
+    ARTNET_DROP_SEQUENCE,
+    // ArtDmx from a third source while merging two
+    ARTNET_DROP_MERGE,
+    // ArtRdm for a port with its queue of requests full
+    ARTNET_DROP_RDM,
+    // sACN malformed, previewed, not DMX or from one source too many
+    ARTNET_DROP_SACN,
+    // sACN from a lower priority source than another on the universe
+    ARTNET_DROP_PRIORITY,
+    ARTNET_DROP_REASONS
+} ArtNetDropReason;
+
+// Protocols a node receives, each has its packets and their cost counted
+typedef enum ArtNetProtocolTag
+{
+    ARTNET_PROTOCOL_ARTNET,
+    ARTNET_PROTOCOL_SACN,
+    ARTNET_PROTOCOLS
+} ArtNetProtocol;
+
+typedef struct ArtNetMetricsTag
+{
+    unsigned long opcodes[ARTNET_METRIC_OPCODES];
+    unsigned long drops[ARTNET_DROP_REASONS];
+    // Clock ticks from receiving the packet that triggered an output (its
+    // ArtDmx, ArtSync or the timecode frame) to the callback returning
+    unsigned long latency[ARTNET_LATENCY_BUCKETS];
+    unsigned long latencyMax;
+    // Packets of each protocol and the clock ticks spent processing them
+    unsigned long protocolPackets[ARTNET_PROTOCOLS];
+    unsigned long protocolTicks[ARTNET_PROTOCOLS];
+} ArtNetMetrics_t;
+
+// The counters of a node along with those of its PortCount ports
+template <unsigned short PortCount>
+struct ArtNetPortMetrics_t : public ArtNetMetrics_t
+{
+    // Frames output by each port, and how many in the last period
+    unsigned long frames[PortCount];
+    unsigned int frameRate[PortCount];
+};
+
+// Counters for a node, attach with ArtNet::SetMetrics.  The node only
+// counts, anything derived from the counters is left to whoever reads a
+// snapshot.  The per port counters are held by ArtNetPortMetrics, sized
+// to match the node, and copied with the rest by its Snapshot().
+class ArtNetMetricsBase
+{
+  private:
+    ArtNetMetrics_t counts;
+    unsigned long (*clock)(void);
+    unsigned long arrival;
+    unsigned long start;
+    // Frames output by each port, and how many in the last period
+    unsigned long *frames;
+    unsigned long *framesLast;
+    unsigned int *frameRate;
+    unsigned short ports;
+    unsigned long lastRate;
+
+  protected:
+    void begin(unsigned long *frames, unsigned long *framesLast, unsigned int *frameRate, unsigned short ports);
+
+  public:
+    // Source of the latency ticks, micros() unless set
+    void SetClock(unsigned long (*clock)(void));
+    void Reset();
+    // Copies the counters for the node as a whole
+    void Snapshot(ArtNetMetrics_t *out);
+    // Called by the node as packets are processed, inline as they are on
+    // the path of every packet
+    void Arrive()
+    {
+        this->arrival = this->start = this->clock();
+    }
+    // A packet of a batch that has already arrived
+    void Begin()
+    {
+        this->start = this->clock();
+    }
+    void Processed(ArtNetProtocol protocol)
+    {
+        this->counts.protocolPackets[protocol]++;
+        this->counts.protocolTicks[protocol] += this->clock() - this->start;
+    }
+    void Opcode(ArtNetMetricOpcode opcode)
+    {
+        this->counts.opcodes[opcode]++;
+    }
+    void Drop(ArtNetDropReason reason)
+    {
+        this->counts.drops[reason]++;
+    }
+    // A frame handed to the output callback, not one skipped as unchanged
+    void Frame(unsigned short port);
+    void Service(unsigned long now);
+};
+
+template <unsigned short PortCount>
+class ArtNetPortMetrics : public ArtNetMetricsBase
+{
+  private:
+    unsigned long portFrames[PortCount];
+    unsigned long portFramesLast[PortCount];
+    unsigned int portFrameRate[PortCount];
+
+  public:
+    ArtNetPortMetrics()
+    {
+        this->begin(this->portFrames, this->portFramesLast, this->portFrameRate, PortCount);
+    }
+    using ArtNetMetricsBase::Snapshot;
+    // Copies all of the counters at once
+    void Snapshot(ArtNetPortMetrics_t<PortCount> *out)
+    {
+        ArtNetMetricsBase::Snapshot(out);
+        memcpy(out->frames, this->portFrames, sizeof(out->frames));
+        memcpy(out->frameRate, this->portFrameRate, sizeof(out->frameRate));
+    }
+};
+
+// For the original four port node
+typedef ArtNetPortMetrics<MAX_PORTS> ArtNetMetrics;
+
+#endif
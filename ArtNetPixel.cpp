@@ -0,0 +1,164 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetPixel.h"
+#include <math.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Offset of each incoming colour within a pixel of the LED buffer
+static const unsigned char colourOffsets[][4] = {
+    { 0, 1, 2, 3 },   // RGB
+    { 0, 2, 1, 3 },   // RBG
+    { 1, 0, 2, 3 },   // GRB
+    { 2, 0, 1, 3 },   // GBR
+    { 1, 2, 0, 3 },   // BRG
+    { 2, 1, 0, 3 },   // BGR
+    { 0, 1, 2, 3 }    // RGBW
+};
+
+#if defined(__SSSE3__)
+// Source byte of output byte k for five pixels in a 16 byte vector, the last
+// byte is the next pixel's red which the following store overwrites
+static constexpr char shuffleIndex(int k, unsigned char R, unsigned char G)
+{
+    return k == 15 ? 15 : (k / 3) * 3 + ((k % 3) == R ? 0 : (k % 3) == G ? 1 : 2);
+}
+#endif
+
+// R, G and B are the offsets in the LED of the DMX red, green and blue
+template <unsigned char R, unsigned char G, unsigned char B>
+static void pixelCopy(byte *out, const byte *in, word pixels, const ArtNetGamma_t *)
+{
+#if defined(__SSSE3__)
+    const __m128i shuffle = _mm_setr_epi8(
+        shuffleIndex(0, R, G), shuffleIndex(1, R, G), shuffleIndex(2, R, G), shuffleIndex(3, R, G),
+        shuffleIndex(4, R, G), shuffleIndex(5, R, G), shuffleIndex(6, R, G), shuffleIndex(7, R, G),
+        shuffleIndex(8, R, G), shuffleIndex(9, R, G), shuffleIndex(10, R, G), shuffleIndex(11, R, G),
+        shuffleIndex(12, R, G), shuffleIndex(13, R, G), shuffleIndex(14, R, G), shuffleIndex(15, R, G));
+    // Six pixels keeps the 16 byte load and store inside the buffers
+    for (; pixels >= 6; pixels -= 5) {
+        __m128i v = _mm_loadu_si128((const __m128i*)in);
+        _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(v, shuffle));
+        in += 15;
+        out += 15;
+    }
+#elif defined(__ARM_NEON)
+    for (; pixels >= 16; pixels -= 16) {
+        uint8x16x3_t v = vld3q_u8(in);
+        uint8x16x3_t o;
+        o.val[R] = v.val[0];
+        o.val[G] = v.val[1];
+        o.val[B] = v.val[2];
+        vst3q_u8(out, o);
+        in += 48;
+        out += 48;
+    }
+#endif
+    while (pixels--) {
+        out[R] = in[0];
+        out[G] = in[1];
+        out[B] = in[2];
+        in += 3;
+        out += 3;
+    }
+}
+
+// Same order in and out, nothing to do but copy
+template <>
+void pixelCopy<0, 1, 2>(byte *out, const byte *in, word pixels, const ArtNetGamma_t *)
+{
+    memcpy(out, in, pixels * 3);
+}
+
+template <unsigned char R, unsigned char G, unsigned char B>
+static void pixelGamma(byte *out, const byte *in, word pixels, const ArtNetGamma_t *gamma)
+{
+    while (pixels--) {
+        out[R] = gamma->table[0][in[0]];
+        out[G] = gamma->table[1][in[1]];
+        out[B] = gamma->table[2][in[2]];
+        in += 3;
+        out += 3;
+    }
+}
+
+static void pixelCopyRgbw(byte *out, const byte *in, word pixels, const ArtNetGamma_t *)
+{
+    memcpy(out, in, pixels * 4);
+}
+
+static void pixelGammaRgbw(byte *out, const byte *in, word pixels, const ArtNetGamma_t *gamma)
+{
+    while (pixels--) {
+        out[0] = gamma->table[0][in[0]];
+        out[1] = gamma->table[1][in[1]];
+        out[2] = gamma->table[2][in[2]];
+        out[3] = gamma->table[3][in[3]];
+        in += 4;
+        out += 4;
+    }
+}
+
+static const ArtNetPixelKernel copyKernels[] = {
+    pixelCopy<0, 1, 2>,
+    pixelCopy<0, 2, 1>,
+    pixelCopy<1, 0, 2>,
+    pixelCopy<2, 0, 1>,
+    pixelCopy<1, 2, 0>,
+    pixelCopy<2, 1, 0>,
+    pixelCopyRgbw
+};
+
+static const ArtNetPixelKernel gammaKernels[] = {
+    pixelGamma<0, 1, 2>,
+    pixelGamma<0, 2, 1>,
+    pixelGamma<1, 0, 2>,
+    pixelGamma<2, 0, 1>,
+    pixelGamma<1, 2, 0>,
+    pixelGamma<2, 1, 0>,
+    pixelGammaRgbw
+};
+
+void ArtNetGammaBuild(ArtNetGamma_t *gamma, float exponent, const byte scale[4])
+{
+    unsigned char colour;
+    unsigned short i;
+
+    for (colour = 0; colour < 4; ++colour) {
+        for (i = 0; i < 256; ++i) {
+            gamma->table[colour][i] = (byte)(pow(i / 255.0, exponent) * scale[colour] + 0.5);
+        }
+    }
+}
+
+ArtNetPixelKernel ArtNetPixelSelect(ArtNetColourOrder order, unsigned char gamma)
+{
+    return gamma ? gammaKernels[order] : copyKernels[order];
+}
+
+const unsigned char *ArtNetPixelOffsets(ArtNetColourOrder order)
+{
+    return colourOffsets[order];
+}
@@ -0,0 +1,56 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_PIXEL_H
+#define ARTNET_PIXEL_H
+
+#include <Arduino.h>
+
+// Order of the colours in the LED buffer, the DMX data is always R, G, B (, W)
+typedef enum ArtNetColourOrderTag {
+    ARTNET_ORDER_RGB,
+    ARTNET_ORDER_RBG,
+    ARTNET_ORDER_GRB,
+    ARTNET_ORDER_GBR,
+    ARTNET_ORDER_BRG,
+    ARTNET_ORDER_BGR,
+    ARTNET_ORDER_RGBW
+} ArtNetColourOrder;
+
+// Lookup per DMX colour (R, G, B, W) applied as pixels are converted, used
+// for gamma correction and white balance.  1k of RAM, so only allocate one
+// where it is wanted.
+typedef struct ArtNetGammaTag
+{
+    byte table[4][256];
+} ArtNetGamma_t;
+
+// Converts whole pixels from DMX order in to the LED buffer, gamma may be NULL
+typedef void (*ArtNetPixelKernel)(byte *out, const byte *in, word pixels, const ArtNetGamma_t *gamma);
+
+// Fills the lookups with out = scale * (in / 255) ^ exponent, scale being
+// the white balance of each colour (255 for none)
+void ArtNetGammaBuild(ArtNetGamma_t *gamma, float exponent, const byte scale[4]);
+// The kernel for an order, with or without a gamma lookup
+ArtNetPixelKernel ArtNetPixelSelect(ArtNetColourOrder order, unsigned char gamma);
+// Offset within an LED of each DMX colour
+const unsigned char *ArtNetPixelOffsets(ArtNetColourOrder order);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetPixelMap.h"
+
+ArtNetPixelMap::ArtNetPixelMap(byte *leds, unsigned short pixels, ArtNetColourOrder order, unsigned short startAddress, unsigned short startChannel, unsigned short universeChannels)
+{
+    this->leds = leds;
+    this->pixels = pixels;
+    this->size = order == ARTNET_ORDER_RGBW ? 4 : 3;
+    this->colourOrder = order;
+    this->order = ArtNetPixelOffsets(order);
+    this->gamma = 0;
+    this->kernel = ArtNetPixelSelect(order, 0);
+    this->universeChannels = universeChannels;
+    if (this->universeChannels == 0 || this->universeChannels > ARTNET_DMX_LENGTH) {
+        this->universeChannels = ARTNET_PIXEL_UNIVERSE_CHANNELS;
+    }
+    this->port = ARTNET_PIXEL_NO_PORT;
+    this->next = 0;
+    this->SetStart(startAddress, startChannel);
+}
+
+void ArtNetPixelMap::SetStart(unsigned short startAddress, unsigned short startChannel)
+{
+    this->startAddress = startAddress;
+    this->startChannel = startChannel;
+    this->layout();
+}
+
+void ArtNetPixelMap::SetGamma(const ArtNetGamma_t *gamma)
+{
+    this->gamma = gamma;
+    this->kernel = ArtNetPixelSelect(this->colourOrder, gamma != 0);
+}
+
+unsigned short ArtNetPixelMap::GetStartAddress()
+{
+    return this->startAddress;
+}
+
+unsigned char ArtNetPixelMap::GetUniverses()
+{
+    return this->universes;
+}
+
+unsigned short ArtNetPixelMap::GetPixels()
+{
+    return this->mapped;
+}
+
+void ArtNetPixelMap::layout()
+{
+    unsigned long limit = (unsigned long)ARTNET_PIXEL_MAX_UNIVERSES * this->universeChannels;
+    unsigned long channels = (unsigned long)this->startChannel + (unsigned long)this->pixels * this->size;
+    unsigned long universes;
+
+    this->mapped = this->pixels;
+    if (channels > limit) {
+        // Too long, the end of the strip is left unmapped
+        this->mapped = this->startChannel < limit ? (limit - this->startChannel) / this->size : 0;
+        channels = (unsigned long)this->startChannel + (unsigned long)this->mapped * this->size;
+    }
+    universes = (channels + this->universeChannels - 1) / this->universeChannels;
+
+    this->universes = universes;
+    // A bit per universe, shifted in two steps so 32 universes don't
+    // shift by the width of the mask
+    this->expected = universes ? (2UL << (universes - 1)) - 1 : 0;
+    this->received = 0;
+}
+
+unsigned char ArtNetPixelMap::Write(unsigned short address, const byte *data, word length)
+{
+    unsigned short universe;
+    unsigned long total;
+    long stream;
+    word c, end;
+    word whole;
+    unsigned char component;
+    byte *out;
+
+    universe = (address - this->startAddress) & 0x7fff;
+    if (universe >= this->universes) return 0;
+
+    if (length > this->universeChannels) length = this->universeChannels;
+    this->received |= 1UL << universe;
+
+    // Position of data[0] within the strip's channels
+    stream = (long)universe * this->universeChannels - this->startChannel;
+    c = 0;
+    if (stream < 0) {
+        if ((unsigned long)-stream >= length) return 1;
+        c = -stream;
+        stream = 0;
+    }
+    total = (unsigned long)this->mapped * this->size;
+    if ((unsigned long)stream >= total) return 1;
+    end = length;
+    if (total - stream < (unsigned long)(end - c)) end = c + (total - stream);
+
+    out = this->leds + (stream / this->size) * this->size;
+    component = stream % this->size;
+
+    // The end of a pixel started in the previous universe
+    while (component && c < end) {
+        out[this->order[component]] = this->gamma ? this->gamma->table[component][data[c]] : data[c];
+        c++;
+        if (++component == this->size) {
+            component = 0;
+            out += this->size;
+        }
+    }
+
+    // Whole pixels
+    whole = (end - c) / this->size;
+    this->kernel(out, data + c, whole, this->gamma);
+    c += whole * this->size;
+    out += whole * this->size;
+
+    // The start of a pixel that carries on in the next universe
+    for (component = 0; c < end; ++component, ++c) {
+        out[this->order[component]] = this->gamma ? this->gamma->table[component][data[c]] : data[c];
+    }
+
+    return 1;
+}
+
+unsigned char ArtNetPixelMap::Complete()
+{
+    return (this->received & this->expected) == this->expected;
+}
+
+void ArtNetPixelMap::Shown()
+{
+    this->received = 0;
+}
@@ -0,0 +1,84 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_PIXEL_MAP_H
+#define ARTNET_PIXEL_MAP_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+#include "ArtNetPixel.h"
+
+// A strip may span at most this many universes, no more than 32 as each
+// is a bit of a mask
+#define ARTNET_PIXEL_MAX_UNIVERSES 32
+// Channels used in each universe by default, 170 whole RGB pixels
+#define ARTNET_PIXEL_UNIVERSE_CHANNELS 510
+
+// Maps a run of consecutive universes on to one LED buffer.  The strip
+// starts at startChannel of the universe at startAddress and carries on
+// through the following universes.  Set universeChannels to 512 to pack
+// pixels across universe boundaries rather than the usual 170 per universe.
+// Attach to a node with ArtNet::AddPixelMap.
+class ArtNetPixelMap
+{
+  friend class ArtNetBase;
+
+  private:
+    byte *leds;
+    unsigned short pixels;
+    // Those within ARTNET_PIXEL_MAX_UNIVERSES
+    unsigned short mapped;
+    unsigned char size;
+    const unsigned char *order;
+    const ArtNetGamma_t *gamma;
+    ArtNetPixelKernel kernel;
+    ArtNetColourOrder colourOrder;
+    unsigned short startAddress;
+    unsigned short startChannel;
+    unsigned short universeChannels;
+    unsigned char universes;
+    unsigned long received;
+    unsigned long expected;
+    // Port the start address follows, or ARTNET_PIXEL_NO_PORT
+    unsigned short port;
+    ArtNetPixelMap *next;
+
+  public:
+    ArtNetPixelMap(byte *leds, unsigned short pixels, ArtNetColourOrder order, unsigned short startAddress, unsigned short startChannel, unsigned short universeChannels);
+    void SetStart(unsigned short startAddress, unsigned short startChannel);
+    // Lookup applied to every colour as it is written, NULL for none
+    void SetGamma(const ArtNetGamma_t *gamma);
+    unsigned short GetStartAddress();
+    unsigned char GetUniverses();
+    // Pixels mapped, fewer than given if the strip needs more than
+    // ARTNET_PIXEL_MAX_UNIVERSES universes
+    unsigned short GetPixels();
+    // Copy a universe in to the strip, returns 0 if it isn't part of it
+    unsigned char Write(unsigned short address, const byte *data, word length);
+    // Every universe of the strip has arrived since the last Shown()
+    unsigned char Complete();
+    void Shown();
+  private:
+    void layout();
+};
+
+#define ARTNET_PIXEL_NO_PORT 0xffff
+
+#endif
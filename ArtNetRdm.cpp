@@ -0,0 +1,439 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetRdm.h"
+
+// What is on the line, and the next discovery step
+#define ARTNET_RDM_LINE_REQUEST 1
+#define ARTNET_RDM_LINE_UNMUTE  2
+#define ARTNET_RDM_LINE_BRANCH  3
+#define ARTNET_RDM_LINE_MUTE    4
+
+#define RDM_DISCOVERY_COMMAND 0x10
+#define RDM_DISC_UNIQUE_BRANCH 0x0001
+#define RDM_DISC_MUTE 0x0002
+#define RDM_DISC_UN_MUTE 0x0003
+#define RDM_UID_BITS 48
+
+static const byte rdmBroadcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// A DISC_UNIQUE_BRANCH response is the UID and checksum with every byte
+// sent twice, once ORed with 0xaa and once with 0x55
+static unsigned char discoveryDecode(const byte *data, word length, byte uid[6])
+{
+    unsigned short sum = 0;
+    unsigned char i;
+    word start = 0;
+
+    // Up to seven bytes of preamble then the separator
+    while (start < length && start < 7 && data[start] == 0xfe) ++start;
+    if (start >= length || data[start] != 0xaa) return 0;
+    ++start;
+    if (length - start < 16) return 0;
+    data += start;
+
+    for (i = 0; i < 12; ++i) {
+        sum += data[i];
+    }
+    for (i = 0; i < 6; ++i) {
+        uid[i] = data[2 * i] & data[2 * i + 1];
+    }
+    return (((data[12] & data[13]) << 8) | (data[14] & data[15])) == sum;
+}
+
+ArtNetRdm::ArtNetRdm(const byte uid[6], unsigned char (*start)(unsigned short port, const byte *request, word length), ArtNetRdmResult (*poll)(unsigned short port, byte *response, word *length))
+{
+    this->port = 0;
+    this->start = start;
+    this->poll = poll;
+    memcpy(this->uid, uid, 6);
+    this->transaction = 0;
+    this->devices = 0;
+    this->todChanged = 0;
+    this->head = 0;
+    this->count = 0;
+    this->busy = 0;
+    this->started = 0;
+    this->incremental = 1;
+    this->discovered = 0;
+    this->responseLength = 0;
+    this->dropped = 0;
+    this->timeouts = 0;
+
+    memset(this->packet, 0, ARTNET_RDM_HEADER);
+    memcpy(this->packet, "Art-Net", 8);
+    this->packet[8] = 0x00;     // OpRdm, little endian
+    this->packet[9] = 0x83;
+    this->packet[10] = 0;       // Protocol version 14
+    this->packet[11] = 14;
+    this->packet[12] = 0x01;    // RDM standard V1.0
+
+    memset(this->todPacket, 0, ARTNET_TOD_HEADER);
+    memcpy(this->todPacket, "Art-Net", 8);
+    this->todPacket[8] = 0x00;  // OpTodData
+    this->todPacket[9] = 0x81;
+    this->todPacket[10] = 0;
+    this->todPacket[11] = 14;
+    this->todPacket[12] = 0x01;
+
+    // Full discovery on power up
+    this->Discover();
+}
+
+unsigned char ArtNetRdm::Queue(const byte ip[4], const byte *request, word length)
+{
+    ArtNetRdmRequest_t *slot;
+
+    // Anything too short for a header and checksum, or too long, is ignored
+    if (length < 25 || length > ARTNET_RDM_PACKET) {
+        return 1;
+    }
+    // Unicast requests only go to ports with the device
+    if ((request[4] != 0xff || request[5] != 0xff || request[6] != 0xff || request[7] != 0xff) &&
+            this->find(&request[2]) == this->devices) {
+        return 1;
+    }
+    if (this->count == ARTNET_RDM_QUEUE) {
+        this->dropped++;
+        return 0;
+    }
+
+    slot = &this->queue[(this->head + this->count) % ARTNET_RDM_QUEUE];
+    memcpy(slot->ip, ip, 4);
+    slot->length = length;
+    memcpy(slot->data, request, length);
+    this->count++;
+    return 1;
+}
+
+unsigned char ArtNetRdm::Service(unsigned long now)
+{
+    ArtNetRdmResult result;
+    word length = 0;
+
+    if (this->busy) {
+        result = this->poll(this->port, &this->packet[ARTNET_RDM_HEADER], &length);
+        if (result == ARTNET_RDM_PENDING) {
+            if (now - this->started < ARTNET_RDM_TIMEOUT) {
+                return 0;
+            }
+            // The backend lost the transaction, carry on without it
+            this->timeouts++;
+            result = ARTNET_RDM_NONE;
+        }
+        if (this->finish(result, length)) {
+            // The response must be sent before the buffer is used again
+            return 1;
+        }
+    }
+
+    this->startNext(now);
+    return 0;
+}
+
+void ArtNetRdm::startNext(unsigned long now)
+{
+    ArtNetRdmRequest_t *request;
+    unsigned long long lower, upper;
+    byte range[12];
+    unsigned char i;
+    word length;
+
+    // Controllers come first, discovery only uses an idle line
+    if (this->count) {
+        request = &this->queue[this->head];
+        if (this->start(this->port, request->data, request->length)) {
+            this->busy = ARTNET_RDM_LINE_REQUEST;
+            this->started = now;
+        }
+        return;
+    }
+
+    if (!this->discovering && this->incremental && now - this->discovered >= ARTNET_RDM_INCREMENTAL) {
+        this->Discover();
+    }
+
+    switch (this->discovering) {
+        case ARTNET_RDM_LINE_UNMUTE:
+            length = this->build(rdmBroadcast, RDM_DISCOVERY_COMMAND, RDM_DISC_UN_MUTE, 0, 0);
+            break;
+        case ARTNET_RDM_LINE_BRANCH:
+            lower = this->prefix << (RDM_UID_BITS - this->depth);
+            upper = lower | ((1ULL << (RDM_UID_BITS - this->depth)) - 1);
+            for (i = 0; i < 6; ++i) {
+                range[i] = lower >> (40 - 8 * i);
+                range[6 + i] = upper >> (40 - 8 * i);
+            }
+            length = this->build(rdmBroadcast, RDM_DISCOVERY_COMMAND, RDM_DISC_UNIQUE_BRANCH, range, sizeof(range));
+            break;
+        case ARTNET_RDM_LINE_MUTE:
+            length = this->build(this->found, RDM_DISCOVERY_COMMAND, RDM_DISC_MUTE, 0, 0);
+            break;
+        default:
+            return;
+    }
+    if (this->start(this->port, this->request, length)) {
+        this->busy = this->discovering;
+        this->started = now;
+    } else {
+        // Built again next time with a new transaction number
+        this->transaction--;
+    }
+}
+
+unsigned char ArtNetRdm::finish(ArtNetRdmResult result, word length)
+{
+    unsigned char line = this->busy;
+
+    this->busy = 0;
+    if (line == ARTNET_RDM_LINE_REQUEST) {
+        memcpy(this->replyIp, this->queue[this->head].ip, 4);
+        this->head = (this->head + 1) % ARTNET_RDM_QUEUE;
+        this->count--;
+        if (result == ARTNET_RDM_RESPONSE && length > 0 && length <= ARTNET_RDM_PACKET) {
+            this->responseLength = length;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Discovery was restarted or ended while this was on the line
+    if (line != this->discovering) {
+        return 0;
+    }
+    switch (line) {
+        case ARTNET_RDM_LINE_UNMUTE:
+            this->prefix = 0;
+            this->depth = 0;
+            this->discovering = ARTNET_RDM_LINE_BRANCH;
+            break;
+        case ARTNET_RDM_LINE_BRANCH:
+            this->branch(result, length);
+            break;
+        case ARTNET_RDM_LINE_MUTE:
+            // Ask the same branch again for anyone else in it
+            this->discovering = ARTNET_RDM_LINE_BRANCH;
+            break;
+    }
+    return 0;
+}
+
+void ArtNetRdm::branch(ArtNetRdmResult result, word length)
+{
+    byte uid[6];
+    unsigned char device;
+
+    if (result == ARTNET_RDM_NONE) {
+        this->advance();
+        return;
+    }
+    if (result == ARTNET_RDM_RESPONSE && discoveryDecode(&this->packet[ARTNET_RDM_HEADER], length, uid)) {
+        if (memcmp(uid, this->found, 6) == 0) {
+            // Answered again after being muted, don't ask it forever
+            this->advance();
+            return;
+        }
+        memcpy(this->found, uid, 6);
+        device = this->find(uid);
+        if (device == this->devices && this->devices < ARTNET_RDM_DEVICES) {
+            memcpy(this->tod[this->devices++], uid, 6);
+            this->todChanged = 1;
+        }
+        if (device < ARTNET_RDM_DEVICES) {
+            this->seen[device >> 3] |= 1 << (device & 7);
+        }
+        this->discovering = ARTNET_RDM_LINE_MUTE;
+        return;
+    }
+
+    // More than one device answered, split the branch in two
+    if (this->depth < RDM_UID_BITS) {
+        this->depth++;
+        this->prefix <<= 1;
+    } else {
+        this->advance();
+    }
+}
+
+void ArtNetRdm::advance()
+{
+    // On to the next branch not yet asked, up the tree when both halves
+    // have been
+    while (this->depth > 0 && (this->prefix & 1)) {
+        this->prefix >>= 1;
+        this->depth--;
+    }
+    if (this->depth == 0) {
+        this->endPass();
+        return;
+    }
+    this->prefix |= 1;
+}
+
+void ArtNetRdm::endPass()
+{
+    unsigned char i, kept = 0;
+
+    // Anything that didn't answer this pass has gone
+    for (i = 0; i < this->devices; ++i) {
+        if (this->seen[i >> 3] & (1 << (i & 7))) {
+            if (kept != i) {
+                memcpy(this->tod[kept], this->tod[i], 6);
+            }
+            kept++;
+        }
+    }
+    if (kept != this->devices) {
+        this->devices = kept;
+        this->todChanged = 1;
+    }
+    this->discovering = 0;
+    this->discovered = this->started;
+}
+
+word ArtNetRdm::build(const byte dest[6], byte commandClass, unsigned short pid, const byte *data, byte length)
+{
+    byte *out = this->request;
+    // The message without the start code, checksummed from the start code
+    word size = 23 + length;
+    unsigned short sum = 0xcc;
+    word i;
+
+    out[0] = 0x01;              // Sub start code
+    out[1] = 24 + length;       // Message length, counting the start code
+    memcpy(&out[2], dest, 6);
+    memcpy(&out[8], this->uid, 6);
+    out[14] = this->transaction++;
+    out[15] = 1;                // Port ID
+    out[16] = 0;                // Message count
+    out[17] = 0;                // Sub-device
+    out[18] = 0;
+    out[19] = commandClass;
+    out[20] = pid >> 8;
+    out[21] = pid & 0xff;
+    out[22] = length;
+    if (length) {
+        memcpy(&out[23], data, length);
+    }
+    for (i = 0; i < size; ++i) {
+        sum += out[i];
+    }
+    out[size] = sum >> 8;
+    out[size + 1] = sum & 0xff;
+    return size + 2;
+}
+
+unsigned char ArtNetRdm::find(const byte uid[6])
+{
+    unsigned char i;
+    for (i = 0; i < this->devices; ++i) {
+        if (memcmp(this->tod[i], uid, 6) == 0) break;
+    }
+    return i;
+}
+
+const byte *ArtNetRdm::Response(unsigned short address, byte ip[4], word *length)
+{
+    this->packet[21] = (address >> 8) & 0x7f;
+    this->packet[22] = 0;       // ArProcess
+    this->packet[23] = address & 0xff;
+    memcpy(ip, this->replyIp, 4);
+    *length = ARTNET_RDM_HEADER + this->responseLength;
+    return this->packet;
+}
+
+const byte *ArtNetRdm::Tod(unsigned short address, byte physical, byte bindIndex, word *length)
+{
+    this->todPacket[13] = physical;
+    this->todPacket[20] = bindIndex;
+    this->todPacket[21] = (address >> 8) & 0x7f;
+    this->todPacket[22] = 0;    // TodFull
+    this->todPacket[23] = address & 0xff;
+    this->todPacket[24] = 0;    // UidTotal
+    this->todPacket[25] = this->devices;
+    this->todPacket[26] = 0;    // BlockCount
+    this->todPacket[27] = this->devices;
+    memcpy(&this->todPacket[ARTNET_TOD_HEADER], this->tod, 6 * this->devices);
+    *length = ARTNET_TOD_HEADER + 6 * this->devices;
+    return this->todPacket;
+}
+
+unsigned char ArtNetRdm::TodChanged()
+{
+    unsigned char changed = this->todChanged;
+
+    // Announced once the pass is over rather than a device at a time
+    if (this->discovering) {
+        return 0;
+    }
+    this->todChanged = 0;
+    return changed;
+}
+
+void ArtNetRdm::Flush()
+{
+    this->devices = 0;
+    this->todChanged = 1;
+    this->Discover();
+}
+
+void ArtNetRdm::Discover()
+{
+    memset(this->seen, 0, sizeof(this->seen));
+    memset(this->found, 0, sizeof(this->found));
+    this->discovering = ARTNET_RDM_LINE_UNMUTE;
+}
+
+void ArtNetRdm::EndDiscovery()
+{
+    this->discovering = 0;
+    this->discovered = millis();
+}
+
+void ArtNetRdm::SetIncremental(unsigned char incremental)
+{
+    this->incremental = incremental;
+}
+
+unsigned char ArtNetRdm::GetDevices()
+{
+    return this->devices;
+}
+
+const byte *ArtNetRdm::GetDevice(unsigned char device)
+{
+    return device < this->devices ? this->tod[device] : 0;
+}
+
+unsigned char ArtNetRdm::Discovering()
+{
+    return this->discovering != 0;
+}
+
+unsigned int ArtNetRdm::GetDropCount()
+{
+    return this->dropped;
+}
+
+unsigned int ArtNetRdm::GetTimeoutCount()
+{
+    return this->timeouts;
+}
@@ -0,0 +1,147 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARTNET_RDM_H
+#define ARTNET_RDM_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Devices in the table of a port
+#define ARTNET_RDM_DEVICES 32
+// Requests from controllers waiting for the line
+#define ARTNET_RDM_QUEUE 4
+// Longest RDM message without the start code, with its checksum
+#define ARTNET_RDM_PACKET 257
+// Bytes before the RDM message in an ArtRdm
+#define ARTNET_RDM_HEADER 24
+// Bytes before the UIDs in an ArtTodData
+#define ARTNET_TOD_HEADER 28
+// Milliseconds before a transaction the backend never finished is abandoned
+#define ARTNET_RDM_TIMEOUT 50
+// Milliseconds between incremental discovery passes
+#define ARTNET_RDM_INCREMENTAL 10000
+
+// What the backend has for the transaction on the line
+typedef enum ArtNetRdmResultTag
+{
+    // Still waiting for the response
+    ARTNET_RDM_PENDING,
+    // The response is in the buffer
+    ARTNET_RDM_RESPONSE,
+    // Nothing came back in time, as for any broadcast
+    ARTNET_RDM_NONE,
+    // Discovery responses overlapped
+    ARTNET_RDM_COLLISION
+} ArtNetRdmResult;
+
+typedef struct ArtNetRdmRequestTag
+{
+    byte ip[4];
+    word length;
+    byte data[ARTNET_RDM_PACKET];
+} ArtNetRdmRequest_t;
+
+// RDM for the DMX line of one port, attach to an ARTNET_IN port with
+// ArtNet::SetRdm.  Requests from controllers are queued and the table of
+// devices is discovered a transaction at a time, each call to Service()
+// only starts or checks on one transaction so it never waits for the line.
+//
+// The backend drives the line.  start() sends a request, given without the
+// start code, and returns 0 if the line can't take it yet.  poll() returns
+// ARTNET_RDM_PENDING until the transaction is over, then copies any response
+// (also without the start code, or as received for DISC_UNIQUE_BRANCH) to
+// the buffer of ARTNET_RDM_PACKET bytes.
+class ArtNetRdm
+{
+  friend class ArtNetBase;
+  private:
+    unsigned short port;
+    unsigned char (*start)(unsigned short port, const byte *request, word length);
+    ArtNetRdmResult (*poll)(unsigned short port, byte *response, word *length);
+    byte uid[6];
+    unsigned char transaction;
+    // Table of devices, and those found by the current discovery pass
+    byte tod[ARTNET_RDM_DEVICES][6];
+    unsigned char devices;
+    byte seen[(ARTNET_RDM_DEVICES + 7) / 8];
+    unsigned char todChanged;
+    // Requests from controllers, the head is on the line while busy
+    ArtNetRdmRequest_t queue[ARTNET_RDM_QUEUE];
+    unsigned char head;
+    unsigned char count;
+    // The transaction on the line
+    unsigned char busy;
+    unsigned long started;
+    byte request[ARTNET_RDM_PACKET];
+    // Discovery walks the UID space depth first, a branch at a time
+    unsigned char discovering;
+    unsigned char incremental;
+    unsigned char depth;
+    unsigned long long prefix;
+    byte found[6];
+    unsigned long discovered;
+    // The ArtRdm holding the last response, and the ArtTodData
+    byte packet[ARTNET_RDM_HEADER + ARTNET_RDM_PACKET];
+    word responseLength;
+    byte replyIp[4];
+    byte todPacket[ARTNET_TOD_HEADER + 6 * ARTNET_RDM_DEVICES];
+    unsigned int dropped;
+    unsigned int timeouts;
+
+  public:
+    ArtNetRdm(const byte uid[6], unsigned char (*start)(unsigned short port, const byte *request, word length), ArtNetRdmResult (*poll)(unsigned short port, byte *response, word *length));
+    // Returns 0 and counts a drop if the queue is full, requests for a
+    // device not in the table are ignored
+    unsigned char Queue(const byte ip[4], const byte *request, word length);
+    // Starts or checks on a transaction, returns 1 when there is a
+    // response for Response()
+    unsigned char Service(unsigned long now);
+    // The response as an ArtRdm, and who asked for it
+    const byte *Response(unsigned short address, byte ip[4], word *length);
+    // The table of devices as an ArtTodData
+    const byte *Tod(unsigned short address, byte physical, byte bindIndex, word *length);
+    // Whether the table changed since last asked, not until a discovery
+    // pass is over
+    unsigned char TodChanged();
+    // Empties the table and discovers every device again
+    void Flush();
+    // Starts a discovery pass, keeping the table
+    void Discover();
+    void EndDiscovery();
+    // Repeat discovery every ARTNET_RDM_INCREMENTAL ms, on by default
+    void SetIncremental(unsigned char incremental);
+    unsigned char GetDevices();
+    const byte *GetDevice(unsigned char device);
+    unsigned char Discovering();
+    unsigned int GetDropCount();
+    unsigned int GetTimeoutCount();
+  private:
+    word build(const byte dest[6], byte commandClass, unsigned short pid, const byte *data, byte length);
+    unsigned char find(const byte uid[6]);
+    void startNext(unsigned long now);
+    unsigned char finish(ArtNetRdmResult result, word length);
+    void branch(ArtNetRdmResult result, word length);
+    void advance();
+    void endPass();
+};
+
+#endif
@@ -0,0 +1,197 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetSacn.h"
+
+// Offsets within an E1.31 packet, root layer, framing layer then DMP layer
+#define SACN_ROOT_VECTOR     18
+#define SACN_CID             22
+#define SACN_FRAMING_VECTOR  40
+#define SACN_PRIORITY        108
+#define SACN_SEQUENCE        111
+#define SACN_OPTIONS         112
+#define SACN_UNIVERSE        113
+#define SACN_DMP_VECTOR      117
+#define SACN_DMP_TYPE        118
+#define SACN_FIRST_ADDRESS   119
+#define SACN_INCREMENT       121
+#define SACN_COUNT           123
+#define SACN_START_CODE      125
+#define SACN_DATA            126
+// A synchronisation packet ends after its sync address and reserved bytes
+#define SACN_SYNC_SIZE       49
+
+#define SACN_VECTOR_ROOT_DATA      0x00000004
+#define SACN_VECTOR_ROOT_EXTENDED  0x00000008
+#define SACN_VECTOR_DATA           0x00000002
+#define SACN_VECTOR_SYNC           0x00000001
+#define SACN_VECTOR_DMP_SET        0x02
+#define SACN_DMP_TYPE_DMX          0xa1
+
+#define SACN_OPTION_PREVIEW        (1 << 7)
+#define SACN_OPTION_TERMINATED     (1 << 6)
+
+#define SACN_PRIORITY_MAX 200
+#define SACN_UNIVERSE_MAX 63999
+
+// Preamble size, postamble size and ACN packet identifier
+static const byte sacnPreamble[16] = {
+    0x00, 0x10, 0x00, 0x00, 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0x00, 0x00, 0x00
+};
+
+static inline word sacnWord(const byte *p)
+{
+    return ((word)p[0] << 8) | p[1];
+}
+
+static inline unsigned long sacnLong(const byte *p)
+{
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) | ((unsigned long)p[2] << 8) | p[3];
+}
+
+unsigned char ArtNetSacnIs(const char *packet, word length)
+{
+    return length >= sizeof(sacnPreamble) && memcmp(packet, sacnPreamble, sizeof(sacnPreamble)) == 0;
+}
+
+void ArtNetSacnGroup(word universe, byte ip[4])
+{
+    ip[0] = 239;
+    ip[1] = 255;
+    ip[2] = universe >> 8;
+    ip[3] = universe & 0xff;
+}
+
+ArtNetSacn::ArtNetSacn()
+{
+    this->Clear();
+}
+
+void ArtNetSacn::Clear()
+{
+    memset(this->sources, 0, sizeof(this->sources));
+}
+
+unsigned char ArtNetSacn::GetSources()
+{
+    unsigned long now = millis();
+    unsigned char s, count = 0;
+
+    for (s = 0; s < ARTNET_SACN_SOURCES; ++s) {
+        if (this->sources[s].active && now - this->sources[s].seen <= ARTNET_SACN_TIMEOUT) count++;
+    }
+    return count;
+}
+
+ArtNetSacnResult ArtNetSacn::Receive(const char *packet, word length, ArtNetSacnFrame_t *frame)
+{
+    const byte *p = (const byte*)packet;
+    ArtNetSacnSource_t *source;
+    unsigned long root, now;
+    unsigned char s, found, free, others;
+    byte highest;
+    word universe, count;
+    signed char distance;
+
+    if (!ArtNetSacnIs(packet, length) || length < SACN_FRAMING_VECTOR + 4) {
+        return ARTNET_SACN_INVALID;
+    }
+    root = sacnLong(p + SACN_ROOT_VECTOR);
+    if (root == SACN_VECTOR_ROOT_EXTENDED) {
+        // Universe discovery is of no interest to a receiver
+        if (length >= SACN_SYNC_SIZE && sacnLong(p + SACN_FRAMING_VECTOR) == SACN_VECTOR_SYNC) {
+            return ARTNET_SACN_SYNC;
+        }
+        return ARTNET_SACN_INVALID;
+    }
+    if (root != SACN_VECTOR_ROOT_DATA || length < SACN_DATA ||
+            sacnLong(p + SACN_FRAMING_VECTOR) != SACN_VECTOR_DATA ||
+            p[SACN_DMP_VECTOR] != SACN_VECTOR_DMP_SET || p[SACN_DMP_TYPE] != SACN_DMP_TYPE_DMX ||
+            sacnWord(p + SACN_FIRST_ADDRESS) != 0 || sacnWord(p + SACN_INCREMENT) != 1) {
+        return ARTNET_SACN_INVALID;
+    }
+    universe = sacnWord(p + SACN_UNIVERSE);
+    count = sacnWord(p + SACN_COUNT);
+    if (universe == 0 || universe > SACN_UNIVERSE_MAX || p[SACN_PRIORITY] > SACN_PRIORITY_MAX ||
+            count == 0 || p[SACN_START_CODE] != 0 || (p[SACN_OPTIONS] & SACN_OPTION_PREVIEW)) {
+        // Only live DMX is output, not previews or alternate start codes
+        return ARTNET_SACN_INVALID;
+    }
+
+    // Find the source, a free slot, and the best of the others on the universe
+    now = millis();
+    found = free = ARTNET_SACN_SOURCES;
+    others = 0;
+    highest = 0;
+    for (s = 0; s < ARTNET_SACN_SOURCES; ++s) {
+        source = &this->sources[s];
+        if (source->active && now - source->seen > ARTNET_SACN_TIMEOUT) {
+            source->active = 0;
+        }
+        if (!source->active) {
+            if (free == ARTNET_SACN_SOURCES) free = s;
+            continue;
+        }
+        if (source->universe != universe) continue;
+        if (memcmp(source->cid, p + SACN_CID, sizeof(source->cid)) == 0) {
+            found = s;
+        } else {
+            others = 1;
+            if (source->priority > highest) highest = source->priority;
+        }
+    }
+
+    if (found == ARTNET_SACN_SOURCES) {
+        if (p[SACN_OPTIONS] & SACN_OPTION_TERMINATED) return ARTNET_SACN_TERMINATED;
+        if (free == ARTNET_SACN_SOURCES) return ARTNET_SACN_FULL;
+        source = &this->sources[free];
+        memcpy(source->cid, p + SACN_CID, sizeof(source->cid));
+        source->universe = universe;
+        source->active = 1;
+    } else {
+        source = &this->sources[found];
+        if (p[SACN_OPTIONS] & SACN_OPTION_TERMINATED) {
+            source->active = 0;
+            return ARTNET_SACN_TERMINATED;
+        }
+        distance = (signed char)(p[SACN_SEQUENCE] - source->sequence);
+        if (distance <= 0 && distance > -ARTNET_SACN_RESYNC) {
+            source->seen = now;
+            return ARTNET_SACN_SEQUENCE;
+        }
+    }
+    source->sequence = p[SACN_SEQUENCE];
+    source->priority = p[SACN_PRIORITY];
+    source->seen = now;
+
+    if (others && source->priority < highest) {
+        return ARTNET_SACN_PRIORITY;
+    }
+
+    frame->universe = universe;
+    frame->priority = source->priority;
+    frame->overrides = others && source->priority > highest;
+    frame->data = packet + SACN_DATA;
+    frame->length = count - 1;
+    if (frame->length > length - SACN_DATA) frame->length = length - SACN_DATA;
+    if (frame->length > ARTNET_DMX_LENGTH) frame->length = ARTNET_DMX_LENGTH;
+    return ARTNET_SACN_DATA;
+}
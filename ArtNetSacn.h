@@ -0,0 +1,103 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARTNET_SACN_H
+#define ARTNET_SACN_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Port sACN (E1.31) is sent to, multicast to 239.255.<universe>
+#define UDP_PORT_SACN 5568
+// Sources tracked across every universe for priority and sequence numbers
+#define ARTNET_SACN_SOURCES 8
+// Milliseconds without data before a source is lost, from E1.31
+#define ARTNET_SACN_TIMEOUT 2500
+// sACN universe 1 is Port-Address 0
+#define ARTNET_SACN_UNIVERSE_OFFSET 1
+// A sequence number this far behind the last is taken as a restart
+#define ARTNET_SACN_RESYNC 20
+
+typedef enum ArtNetSacnResultTag
+{
+    // Data from the winning source, to be output
+    ARTNET_SACN_DATA,
+    // A synchronisation packet, staged data should be output
+    ARTNET_SACN_SYNC,
+    // The source stopped sending to the universe
+    ARTNET_SACN_TERMINATED,
+    // Malformed, preview data or not DMX
+    ARTNET_SACN_INVALID,
+    // Repeated or out of order
+    ARTNET_SACN_SEQUENCE,
+    // Another source is sending to the universe at a higher priority
+    ARTNET_SACN_PRIORITY,
+    // No room to track another source
+    ARTNET_SACN_FULL
+} ArtNetSacnResult;
+
+// A data packet, pointing into the datagram it was parsed from
+typedef struct ArtNetSacnFrameTag
+{
+    word universe;
+    byte priority;
+    // Set while lower priority sources are being overridden, whose data
+    // should no longer be merged
+    unsigned char overrides;
+    const char *data;
+    word length;
+} ArtNetSacnFrame_t;
+
+typedef struct ArtNetSacnSourceTag
+{
+    byte cid[16];
+    word universe;
+    byte priority;
+    byte sequence;
+    unsigned long seen;
+    unsigned char active;
+} ArtNetSacnSource_t;
+
+// Whether a datagram carries the ACN root layer, so may be sACN
+unsigned char ArtNetSacnIs(const char *packet, word length);
+// The multicast group a universe is sent to
+void ArtNetSacnGroup(word universe, byte ip[4]);
+
+// Receives sACN data for a node, attach with ArtNet::SetSacn.  Each source
+// is known by its CID on each universe, and only those at the highest
+// priority heard on a universe are output.  Several at the same priority
+// are all passed on, to be merged by the port's ArtNetMerge if it has one.
+class ArtNetSacn
+{
+  private:
+    ArtNetSacnSource_t sources[ARTNET_SACN_SOURCES];
+
+  public:
+    ArtNetSacn();
+    // Parses an E1.31 packet and decides whether its data should be output
+    ArtNetSacnResult Receive(const char *packet, word length, ArtNetSacnFrame_t *frame);
+    // Forget every source
+    void Clear();
+    // Sources sending to any universe
+    unsigned char GetSources();
+};
+
+#endif
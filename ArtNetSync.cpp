@@ -0,0 +1,58 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetSync.h"
+
+ArtNetSyncBuffer::ArtNetSyncBuffer()
+{
+    memset(this->frames, 0, sizeof(this->frames));
+    this->length[0] = 0;
+    this->length[1] = 0;
+    this->back = 1;
+    this->pending = 0;
+}
+
+void ArtNetSyncBuffer::Stage(const byte *data, word length)
+{
+    if (length > ARTNET_DMX_LENGTH) length = ARTNET_DMX_LENGTH;
+    memcpy(this->frames[this->back], data, length);
+    this->length[this->back] = length;
+    this->pending = 1;
+}
+
+unsigned char ArtNetSyncBuffer::Pending()
+{
+    return this->pending;
+}
+
+const byte *ArtNetSyncBuffer::Swap(word *length)
+{
+    if (this->pending) {
+        this->back ^= 1;
+        this->pending = 0;
+    }
+    return this->GetFront(length);
+}
+
+const byte *ArtNetSyncBuffer::GetFront(word *length)
+{
+    *length = this->length[this->back ^ 1];
+    return this->frames[this->back ^ 1];
+}
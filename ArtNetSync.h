@@ -0,0 +1,50 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_SYNC_H
+#define ARTNET_SYNC_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Milliseconds without an ArtSync before a node returns to immediate mode
+#define ARTNET_SYNC_TIMEOUT 4000
+
+// Double buffered frame for one port.  While ArtSync is being received
+// ArtDmx is staged in the back buffer and only becomes current when the
+// ArtSync arrives.  Attach one to a port with ArtNet::SetSync.
+class ArtNetSyncBuffer
+{
+  private:
+    byte frames[2][ARTNET_DMX_LENGTH];
+    word length[2];
+    unsigned char back;
+    unsigned char pending;
+
+  public:
+    ArtNetSyncBuffer();
+    void Stage(const byte *data, word length);
+    unsigned char Pending();
+    // Make the staged frame current and return it
+    const byte *Swap(word *length);
+    const byte *GetFront(word *length);
+};
+
+#endif
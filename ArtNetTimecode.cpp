@@ -0,0 +1,202 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetTimecode.h"
+
+// Frame rate of each type as a fraction
+static const unsigned int timecodeRate[4] = { 24, 25, 30000, 30 };
+static const unsigned int timecodeScale[4] = { 1, 1, 1001, 1 };
+// Frames in a second as numbered
+static const unsigned char timecodeFrames[4] = { 24, 25, 30, 30 };
+
+static unsigned long timecodeClock()
+{
+    return micros();
+}
+
+static long long timecodeFrame(byte type, long long position)
+{
+    long long frames = position * timecodeRate[type];
+    long long second = 1000000LL * timecodeScale[type];
+    // Rounded down before the start of the day too
+    return frames >= 0 ? frames / second : (frames - second + 1) / second;
+}
+
+static long long timecodeStart(byte type, long long frame)
+{
+    return frame * 1000000LL * timecodeScale[type] / timecodeRate[type];
+}
+
+ArtNetTimecode::ArtNetTimecode()
+{
+    this->clock = timecodeClock;
+    this->type = ARTNET_TIMECODE_EBU;
+    this->lock = 0;
+    this->locked = 0;
+    this->anchor = 0;
+    this->anchorLocal = 0;
+    this->lastPacket = 0;
+    this->lastTimecode = 0;
+    this->lastFrame = 0;
+    this->offset = 0;
+    memset(&this->stats, 0, sizeof(this->stats));
+}
+
+void ArtNetTimecode::SetClock(unsigned long (*clock)(void))
+{
+    this->clock = clock ? clock : timecodeClock;
+}
+
+void ArtNetTimecode::SetOffset(long offset)
+{
+    this->offset = offset;
+}
+
+unsigned char ArtNetTimecode::Receive(const byte *packet, word length)
+{
+    unsigned long now, magnitude;
+    long long frame, timecode, predicted, error, interval;
+    unsigned long minutes;
+    byte type;
+
+    if (length < 19) {
+        return 0;
+    }
+    type = packet[18];
+    if (type > ARTNET_TIMECODE_SMPTE || packet[14] >= timecodeFrames[type] ||
+            packet[15] > 59 || packet[16] > 59 || packet[17] > 23) {
+        return 0;
+    }
+    now = this->clock();
+    this->stats.packets++;
+
+    // Frames numbered since midnight, drop frame skips the first two of
+    // every minute but each tenth
+    minutes = packet[17] * 60UL + packet[16];
+    frame = (minutes * 60 + packet[15]) * timecodeFrames[type] + packet[14];
+    if (type == ARTNET_TIMECODE_DF) {
+        frame -= 2 * (minutes - minutes / 10);
+    }
+    timecode = timecodeStart(type, frame);
+
+    if (type != this->type || !this->lock) {
+        // First timecode, or the source changed rate
+        this->type = type;
+        this->locked = 0;
+        this->lock = 1;
+        this->anchor = timecode;
+        this->anchorLocal = now;
+        this->lastPacket = now;
+        this->lastTimecode = timecode;
+        return 1;
+    }
+
+    predicted = this->position(now);
+    error = timecode - predicted;
+    magnitude = error < 0 ? -error : error;
+    if (magnitude > ARTNET_TIMECODE_JUMP) {
+        // Located elsewhere in the show, start again from here
+        if (this->locked) this->stats.jumps++;
+        this->locked = 0;
+        this->lock = 1;
+        this->anchor = timecode;
+        this->anchorLocal = now;
+        this->lastPacket = now;
+        this->lastTimecode = timecode;
+        return 1;
+    }
+
+    // Drift is what remains of the difference over the timecode since the
+    // last, arrival times would weight late packets less
+    interval = timecode - this->lastTimecode;
+    if (interval > 0) {
+        this->stats.drift += error * 1000000000LL / interval / (1 << ARTNET_TIMECODE_FREQUENCY);
+        if (this->stats.drift > ARTNET_TIMECODE_MAX_DRIFT) this->stats.drift = ARTNET_TIMECODE_MAX_DRIFT;
+        if (this->stats.drift < -ARTNET_TIMECODE_MAX_DRIFT) this->stats.drift = -ARTNET_TIMECODE_MAX_DRIFT;
+    }
+    this->anchor = predicted + error / (1 << ARTNET_TIMECODE_PHASE);
+    this->anchorLocal = now;
+    this->lastPacket = now;
+    this->lastTimecode = timecode;
+
+    // As RFC 3550 smooths interarrival jitter
+    this->stats.jitter += ((long)magnitude - (long)this->stats.jitter) / 16;
+    if (magnitude > this->stats.jitterMax) this->stats.jitterMax = magnitude;
+
+    if (this->lock < ARTNET_TIMECODE_LOCK) {
+        this->lock++;
+    } else if (!this->locked) {
+        this->locked = 1;
+        this->lastFrame = timecodeFrame(this->type, predicted - this->offset);
+    }
+    return 1;
+}
+
+ArtNetTimecodeType ArtNetTimecode::GetType()
+{
+    return (ArtNetTimecodeType)this->type;
+}
+
+long long ArtNetTimecode::position(unsigned long now)
+{
+    long long elapsed = (unsigned long)(now - this->anchorLocal);
+    return this->anchor + elapsed + elapsed * this->stats.drift / 1000000000LL;
+}
+
+long long ArtNetTimecode::Position()
+{
+    if (!this->locked) return -1;
+    return this->position(this->clock());
+}
+
+unsigned char ArtNetTimecode::Due()
+{
+    unsigned long now = this->clock();
+    unsigned long late;
+    long long position, frame;
+
+    if (!this->locked) {
+        return 0;
+    }
+    if (now - this->lastPacket > ARTNET_TIMECODE_TIMEOUT * 1000UL) {
+        // The source stopped, anything staged goes out now
+        this->locked = 0;
+        this->lock = 0;
+        return 1;
+    }
+
+    position = this->position(now) - this->offset;
+    frame = timecodeFrame(this->type, position);
+    if (frame <= this->lastFrame) {
+        // Corrections can take the clock back a little
+        return 0;
+    }
+    this->lastFrame = frame;
+    this->stats.frames++;
+    late = position - timecodeStart(this->type, frame);
+    if (late > this->stats.lateMax) this->stats.lateMax = late;
+    return 1;
+}
+
+void ArtNetTimecode::Snapshot(ArtNetTimecodeStats_t *out)
+{
+    memcpy(out, &this->stats, sizeof(this->stats));
+}
@@ -0,0 +1,107 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARTNET_TIMECODE_H
+#define ARTNET_TIMECODE_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Milliseconds without ArtTimeCode before the clock is unlocked
+#define ARTNET_TIMECODE_TIMEOUT 1000
+// Difference in us between a timecode and the clock taken to be a jump
+#define ARTNET_TIMECODE_JUMP 200000
+// ArtTimeCode after a jump before output follows the clock
+#define ARTNET_TIMECODE_LOCK 4
+// Fraction of each difference corrected, as a shift, larger is smoother
+#define ARTNET_TIMECODE_PHASE 3
+#define ARTNET_TIMECODE_FREQUENCY 10
+// Largest drift accepted, parts per billion
+#define ARTNET_TIMECODE_MAX_DRIFT 1000000L
+
+typedef enum ArtNetTimecodeTypeTag
+{
+    ARTNET_TIMECODE_FILM,       // 24 fps
+    ARTNET_TIMECODE_EBU,        // 25 fps
+    ARTNET_TIMECODE_DF,         // 29.97 fps drop frame
+    ARTNET_TIMECODE_SMPTE       // 30 fps
+} ArtNetTimecodeType;
+
+typedef struct ArtNetTimecodeStatsTag
+{
+    unsigned long packets;
+    unsigned long jumps;
+    // The source clock against the local one, parts per billion
+    long drift;
+    // Smoothed and largest difference between a timecode and the clock (us)
+    unsigned long jitter;
+    unsigned long jitterMax;
+    // Frame instants passed, and the longest after its instant one was seen (us)
+    unsigned long frames;
+    unsigned long lateMax;
+} ArtNetTimecodeStats_t;
+
+// A local clock following ArtTimeCode, attach with ArtNet::SetTimecode.
+// Each timecode nudges the phase and drift of the clock rather than setting
+// it, so network jitter is smoothed out.  While locked, ArtDmx for ports
+// with an ArtNetSyncBuffer is staged and output together at each frame
+// instant of the clock instead of when it arrives.
+class ArtNetTimecode
+{
+  private:
+    unsigned long (*clock)(void);
+    byte type;
+    unsigned char lock;
+    unsigned char locked;
+    // The clock is anchor us of timecode at anchorLocal, running at
+    // 1 + drift / 10^9 of the local clock
+    long long anchor;
+    unsigned long anchorLocal;
+    unsigned long lastPacket;
+    long long lastTimecode;
+    long long lastFrame;
+    long offset;
+    ArtNetTimecodeStats_t stats;
+
+  public:
+    ArtNetTimecode();
+    // Source of the local time in us, micros() unless set
+    void SetClock(unsigned long (*clock)(void));
+    // Moves every frame instant later by offset us, or earlier if negative
+    void SetOffset(long offset);
+    // Takes an ArtTimeCode, returns 0 if it isn't a valid one
+    unsigned char Receive(const byte *packet, word length);
+    unsigned char Locked()
+    {
+        return this->locked;
+    }
+    ArtNetTimecodeType GetType();
+    // The timecode now in us since midnight, -1 while unlocked
+    long long Position();
+    // Returns 1 once for every frame instant passed, and when the lock is
+    // lost, as whatever is staged should be output then
+    unsigned char Due();
+    void Snapshot(ArtNetTimecodeStats_t *out);
+  private:
+    long long position(unsigned long now);
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetTransmit.h"
+
+ArtNetTransmit::ArtNetTransmit(const byte *input, word length)
+{
+    memset(this->packet, 0, sizeof(this->packet));
+    memcpy(this->packet, "Art-Net", 8);
+    this->packet[8] = 0x00;     // OpDmx, little endian
+    this->packet[9] = 0x50;
+    this->packet[10] = 0;       // Protocol version 14
+    this->packet[11] = 14;
+    this->lastSent = 0;
+    this->sent = 0;
+    this->sequence = 0;
+    this->SetInput(input, length);
+}
+
+void ArtNetTransmit::SetInput(const byte *input, word length)
+{
+    if (length > ARTNET_DMX_LENGTH) length = ARTNET_DMX_LENGTH;
+    this->input = input;
+    this->length = length;
+    this->sent = 0;
+    memset(&this->packet[ARTNET_DMX_HEADER], 0, ARTNET_DMX_LENGTH);
+}
+
+unsigned char ArtNetTransmit::Due(unsigned long now)
+{
+    byte *data = &this->packet[ARTNET_DMX_HEADER];
+
+    if (!this->sent) {
+        memcpy(data, this->input, this->length);
+        return 1;
+    }
+    if (now - this->lastSent < ARTNET_TRANSMIT_PERIOD) {
+        return 0;
+    }
+    if (memcmp(data, this->input, this->length) != 0) {
+        memcpy(data, this->input, this->length);
+        return 1;
+    }
+    return now - this->lastSent >= ARTNET_TRANSMIT_KEEPALIVE;
+}
+
+const byte *ArtNetTransmit::Send(unsigned long now, unsigned short address, unsigned char physical, word *length)
+{
+    // ArtDmx length must be even, the padding is always zero
+    word dmxLength = (this->length + 1) & ~1;
+
+    if (dmxLength < 2) dmxLength = 2;
+
+    // Sequence 0 disables reordering at the receiver, so skip it
+    if (++this->sequence == 0) this->sequence = 1;
+    this->packet[12] = this->sequence;
+    this->packet[13] = physical;
+    this->packet[14] = address & 0xff;
+    this->packet[15] = (address >> 8) & 0x7f;
+    this->packet[16] = dmxLength >> 8;
+    this->packet[17] = dmxLength & 0xff;
+
+    this->lastSent = now;
+    this->sent = 1;
+    *length = ARTNET_DMX_HEADER + dmxLength;
+    return this->packet;
+}
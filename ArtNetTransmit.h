@@ -0,0 +1,62 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARTNET_TRANSMIT_H
+#define ARTNET_TRANSMIT_H
+
+#include <Arduino.h>
+#include "ArtNet.h"
+
+// Bytes before the data in an ArtDmx
+#define ARTNET_DMX_HEADER 18
+// Shortest time between ArtDmx for one universe, about the DMX frame rate
+#define ARTNET_TRANSMIT_PERIOD 23
+// Unchanged data is still sent this often so receivers keep it
+#define ARTNET_TRANSMIT_KEEPALIVE 4000
+// Shortest time between any two ArtDmx sent by the node
+#define ARTNET_TRANSMIT_SPACING 2
+// Milliseconds between ArtPoll sent to find the subscribers of transmitted universes
+#define ARTNET_TRANSMIT_POLL 3000
+
+// Sends the local DMX input of one port as ArtDmx.  The input buffer is
+// owned by the caller and checked for changes whenever the port is due to
+// send.  Attach one to an ARTNET_OUT port with ArtNet::SetTransmit.
+class ArtNetTransmit
+{
+  private:
+    const byte *input;
+    word length;
+    // The last ArtDmx sent, its data is compared against the input
+    byte packet[ARTNET_DMX_HEADER + ARTNET_DMX_LENGTH];
+    unsigned long lastSent;
+    unsigned char sent;
+    unsigned char sequence;
+
+  public:
+    ArtNetTransmit(const byte *input, word length);
+    void SetInput(const byte *input, word length);
+    // Whether an ArtDmx should be sent now, because the input changed or
+    // for a keep-alive
+    unsigned char Due(unsigned long now);
+    // The ArtDmx to send, only valid after Due returned 1
+    const byte *Send(unsigned long now, unsigned short address, unsigned char physical, word *length);
+};
+
+#endif
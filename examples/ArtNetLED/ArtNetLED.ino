@@ -3,6 +3,7 @@
 #include <EtherCard.h>
 #include <EEPROM.h>
 #include <ArtNet.h>
+#include <ArtNetPixelMap.h>
 #include <FastLED.h>
 
 #define DEFAULT_NUM_LEDS 128
@@ -10,14 +11,18 @@
 #define PORTS 1 // Number of ports to use
 #define CHIPSET TM1809
 #define COLOUR_ORDER RGB
+#define FRAME_PERIOD 25 // Minimum milliseconds between LED refreshes
 
 #define DATA_PIN A5 
 
 CRGB *leds;
+// Feeds the LEDs straight from the universes, spanning more than one if needed
+ArtNetPixelMap *pixelMap;
 
 // Set a different MAC address for each...
 static byte mymac[] = { 0x74, 0x69, 0x69, 0x2D, 0x30, 0x32 };
 byte Ethernet::buffer[600]; // tcp/ip send and receive buffer
+static byte artnetTx[ARTNET_TX_SIZE]; // ArtNet replies are built here
 
 struct Config {
     IPConfiguration iptype;
@@ -28,7 +33,7 @@ struct Config {
     byte valid;
 } config;
 
-ArtNet artnet(mymac, sizeof(config) + 1, Ethernet::buffer + UDP_DATA_P, sizeof(Ethernet::buffer) - UDP_DATA_P, setIP, artSend, callback, PORTS);
+ArtNet artnet(mymac, sizeof(config) + 1, artnetTx, sizeof(artnetTx), setIP, artSend, callback, PORTS);
 
 // Calling 0 breaks the processor causing it to soft reset
 void(* resetFunc) (void) = 0; 
@@ -64,26 +69,20 @@ static void setIP(IPConfiguration iptype, const char *ip, const char *subnet)
   resetFunc();
 }
 
-static void artSend(size_t length, word sport, byte *dip, word dport)
+static void artSend(const byte *data, size_t length, word sport, byte *dip, word dport)
 {
-  ether.sendUdp((char*)Ethernet::buffer + UDP_DATA_P, length, sport, dip, dport);
+  ether.sendUdp((const char*)data, length, sport, dip, dport);
 }
 
 static void callback(unsigned short port, const char *buffer, unsigned short length)
 {
-  if (length < config.startAddress) return;
-  if (port != 0) return;
-  length -= config.startAddress;
-  buffer = buffer + config.startAddress;
-  length = length / 3;
-  if (length > config.connectedLEDs) length = config.connectedLEDs;
-  for (int i = 0; i < length; ++i)
-  {
-    leds[i].r = buffer[i * 3];
-    leds[i].g = buffer[i * 3 + 1];
-    leds[i].b = buffer[i * 3 + 2];
-  }
-  FastSPI_LED.show();
+  // The LEDs are written by pixelMap
+}
+
+// Called by artnet.Service() once a frame has arrived, at most once a FRAME_PERIOD
+static void show()
+{
+  FastLED.show();
 }
 
 static void artnetPacket(word port, byte ip[4], const char *data, word len) {
@@ -108,6 +107,7 @@ void setup() {
   Serial.println(F("Clearing LEDs"));
   memset(leds, 0, sizeof(CRGB) * config.connectedLEDs);
   FastLED.show();
+  pixelMap = new ArtNetPixelMap((byte*)leds, config.connectedLEDs, ARTNET_ORDER_RGB, 0, config.startAddress, ARTNET_PIXEL_UNIVERSE_CHANNELS);
   
   // Startup ethernet
   Serial.println(F("Initialising ENC28J60"));
@@ -146,6 +146,10 @@ void setup() {
   
   Serial.println(F("Configuring ArtNet"));
   artnet.Configure(config.iptype == DHCP, ether.myip);
+  artnet.SetShow(show, FRAME_PERIOD);
+  artnet.AddPixelMap(pixelMap, 0);
+  if (pixelMap->GetPixels() < config.connectedLEDs)
+    Serial.println(F("Too many LEDs, the end of the strip is not mapped"));
   
   // Register listener
   Serial.println(F("Listening on ArtNet"));
@@ -320,6 +324,8 @@ static void setLongName(const char *data, const char *key) {
 
 void loop() {
   word pos = 0;
+  // Refresh the LEDs and save any configuration changes once they settle
+  artnet.Service();
   if ((pos = ether.packetLoop(ether.packetReceive()))) {
     if (strncmp("GET / ", (const char *)(Ethernet::buffer + pos), 6) == 0) {
       // Page emmited
@@ -339,6 +345,7 @@ void loop() {
       artnet.SetSubnet(getIntArg((const char *)(Ethernet::buffer + pos + 11), "subnet", artnet.GetSubnet()));
       setShortName((const char *)(Ethernet::buffer + pos + 11), "shortname");
       setLongName((const char *)(Ethernet::buffer + pos + 11), "longname");
+      artnet.Commit();
       
       // Send page with new settings
       sendArtNetPage();
@@ -346,6 +353,7 @@ void loop() {
       // Save settings
       config.connectedLEDs = getIntArg((const char *)(Ethernet::buffer + pos + 11), "leds", config.connectedLEDs);
       config.startAddress = getIntArg((const char *)(Ethernet::buffer + pos + 11), "address", config.startAddress + 1) - 1;
+      pixelMap->SetStart(pixelMap->GetStartAddress(), config.startAddress);
       saveConfig();
       
       // Send page with new settings
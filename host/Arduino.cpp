@@ -0,0 +1,88 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <time.h>
+
+/* Clock */
+
+static unsigned long long monotonicMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static unsigned long long startMicros = monotonicMicros();
+
+unsigned long millis()
+{
+    return (unsigned long)((monotonicMicros() - startMicros) / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(monotonicMicros() - startMicros);
+}
+
+/* EEPROM */
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass()
+{
+    this->clear();
+}
+
+byte EEPROMClass::read(int address)
+{
+    this->reads++;
+    if (address < 0 || address >= EEPROM_HOST_SIZE) return 0xff;
+    return this->data[address];
+}
+
+void EEPROMClass::write(int address, byte value)
+{
+    this->writes++;
+    if (address < 0 || address >= EEPROM_HOST_SIZE) return;
+    this->data[address] = value;
+}
+
+void EEPROMClass::update(int address, byte value)
+{
+    if (this->read(address) != value) this->write(address, value);
+}
+
+int EEPROMClass::length()
+{
+    return EEPROM_HOST_SIZE;
+}
+
+void EEPROMClass::clear()
+{
+    memset(this->data, 0xff, EEPROM_HOST_SIZE);
+    this->resetCounters();
+}
+
+void EEPROMClass::resetCounters()
+{
+    this->reads = 0;
+    this->writes = 0;
+}
@@ -0,0 +1,42 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Minimal stand-in for the Arduino core so that the library can be built
+ * and profiled on a Linux host.  Only what the library itself uses lives
+ * here.
+ */
+
+#ifndef ARDUINO_HOST_SHIM_H
+#define ARDUINO_HOST_SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+
+// Milliseconds and microseconds since the shim was first used
+unsigned long millis();
+unsigned long micros();
+
+#endif
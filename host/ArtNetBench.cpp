@@ -0,0 +1,1137 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Host benchmark for ArtNet::ProcessPacket.  Synthetic packets of each
+ * supported op code are pushed through a node and the throughput and
+ * EEPROM traffic is reported per op code.  The pixel conversion kernels
+ * are then timed on their own over a 512 channel universe, a node is
+ * driven through the Linux UDP backend over loopback, a node locked to
+ * ArtTimeCode is fed jittered frames in simulated time, and finally the
+ * sharded runtime is run with increasing numbers of workers.
+ *
+ * Usage: ArtNetBench [iterations]
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ArtNet.h>
+#include <ArtNetMerge.h>
+#include <ArtNetSync.h>
+#include <ArtNetPixelMap.h>
+#include <ArtNetChange.h>
+#include <ArtNetDiscovery.h>
+#include <ArtNetTransmit.h>
+#include <ArtNetMetrics.h>
+#include <ArtNetDiagnostics.h>
+#include <ArtNetRdm.h>
+#include <ArtNetTimecode.h>
+#include <ArtNetSacn.h>
+#include <math.h>
+#include <time.h>
+#include <ArtNetUdp.h>
+#include <ArtNetShards.h>
+#include <ArtNetRdmMock.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define BENCH_PORTS 4
+#define BENCH_DEFAULT_ITERATIONS 200000
+#define BENCH_PIXELS 1000
+#define BENCH_MAX_UNIVERSES 8
+#define BENCH_GATEWAY_UNIVERSES 1024
+#define BENCH_GATEWAY_RATE 44
+#define BENCH_SHARD_UNIVERSES 256
+#define BENCH_PAGE_PORTS 256
+#define BENCH_RDM_DEVICES 16
+#define BENCH_TIMECODE_FRAMES 3000
+// Largest sACN data packet
+#define BENCH_SACN_SIZE 638
+// Microseconds between calls to Service() in the timecode simulation
+#define BENCH_TIMECODE_STEP 250
+
+/**************************************************************************
+ * Node stubs
+ **************************************************************************/
+
+static byte benchMac[] = { 0x74, 0x69, 0x69, 0x2D, 0x30, 0x32 };
+static byte benchIp[] = { 2, 0, 0, 10 };
+static byte benchTx[ARTNET_TX_SIZE];
+
+static unsigned long sendCount;
+static unsigned long callbackCount;
+static unsigned long setIPCount;
+static volatile unsigned char sink;
+static unsigned int staleCount;
+static unsigned long showCount;
+static unsigned long batchCount;
+
+static void benchSetIP(IPConfiguration, const char *, const char *)
+{
+    setIPCount++;
+}
+
+static void benchSend(const byte *data, size_t length, word, byte *, word)
+{
+    sink = data[length - 1];
+    sendCount++;
+}
+
+static void benchSendBatch(const ArtNetSend_t *sends, unsigned char count)
+{
+    sink = sends[count - 1].data[0];
+    sendCount += count;
+    batchCount++;
+}
+
+static void benchRange(unsigned short port, const char *buffer, unsigned short start, unsigned short length)
+{
+    sink = buffer[start + length - 1];
+    callbackCount++;
+}
+
+static void benchShow()
+{
+    showCount++;
+}
+
+static void benchCallback(unsigned short port, const char *buffer, unsigned short length)
+{
+    sink = buffer[length - 1];
+    callbackCount++;
+}
+
+/**************************************************************************
+ * Packet builders
+ **************************************************************************/
+
+static size_t writeHeader(char *packet, unsigned short opcode)
+{
+    memcpy(packet, "Art-Net", 8);
+    packet[8] = opcode & 0xff;
+    packet[9] = opcode >> 8;
+    packet[10] = 0;
+    packet[11] = 14;
+    return 12;
+}
+
+static size_t buildDmx(char *packet, unsigned short universe, unsigned short length)
+{
+    size_t len = writeHeader(packet, 0x5000);
+    unsigned short i;
+    packet[len++] = 0;                  // Sequence - disabled
+    packet[len++] = 0;                  // Physical
+    packet[len++] = universe & 0xff;    // SubUni
+    packet[len++] = universe >> 8;      // Net
+    packet[len++] = length >> 8;
+    packet[len++] = length & 0xff;
+    for (i = 0; i < length; ++i) {
+        packet[len++] = i & 0xff;
+    }
+    return len;
+}
+
+// An E1.31 data packet from a source whose CID is all cid
+static size_t buildSacn(char *packet, unsigned short universe, byte cid, byte priority, unsigned short length)
+{
+    static const char identifier[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+    size_t len = 126 + length;
+    unsigned short i;
+
+    memset(packet, 0, 126);
+    packet[1] = 0x10;                   // Preamble size
+    memcpy(&packet[4], identifier, sizeof(identifier));
+    packet[16] = 0x70 | ((len - 16) >> 8);
+    packet[17] = (len - 16) & 0xff;
+    packet[21] = 0x04;                  // VECTOR_ROOT_E131_DATA
+    memset(&packet[22], cid, 16);
+    packet[38] = 0x70 | ((len - 38) >> 8);
+    packet[39] = (len - 38) & 0xff;
+    packet[43] = 0x02;                  // VECTOR_E131_DATA_PACKET
+    strcpy(&packet[44], "ArtNetBench");
+    packet[108] = priority;
+    packet[111] = 1;                    // Sequence
+    packet[113] = universe >> 8;
+    packet[114] = universe & 0xff;
+    packet[115] = 0x70 | ((len - 115) >> 8);
+    packet[116] = (len - 115) & 0xff;
+    packet[117] = 0x02;                 // VECTOR_DMP_SET_PROPERTY
+    packet[118] = 0xa1;                 // Address and data type
+    packet[122] = 1;                    // Address increment
+    packet[123] = (length + 1) >> 8;
+    packet[124] = (length + 1) & 0xff;
+    for (i = 0; i < length; ++i) {
+        packet[126 + i] = i & 0xff;
+    }
+    return len;
+}
+
+static size_t buildSync(char *packet)
+{
+    size_t len = writeHeader(packet, 0x5200);
+    packet[len++] = 0;                  // Aux1
+    packet[len++] = 0;                  // Aux2
+    return len;
+}
+
+static size_t buildPoll(char *packet)
+{
+    size_t len = writeHeader(packet, 0x2000);
+    packet[len++] = (1 << 1);           // TalkToMe - send on change, unicast
+    packet[len++] = 0x80;               // Priority
+    return len;
+}
+
+static size_t buildPollReply(char *packet)
+{
+    writeHeader(packet, 0x2100);
+    // No protocol version, the IP address follows the op code
+    memset(&packet[10], 0, ARTNET_POLL_REPLY_SIZE - 10);
+    packet[ARTNET_REPLY_IP] = 2;
+    strcpy(&packet[ARTNET_REPLY_SHORT_NAME], "Peer");
+    packet[ARTNET_REPLY_NUM_PORTS + 1] = 4;
+    packet[ARTNET_REPLY_BIND_INDEX] = 1;
+    return ARTNET_POLL_REPLY_SIZE;
+}
+
+static size_t buildAddress(char *packet)
+{
+    size_t len = writeHeader(packet, 0x6000);
+    unsigned char i;
+    packet[len++] = 0;                  // NetSwitch
+    packet[len++] = 0;                  // BindIndex
+    memset(&packet[len], 0, 18 + 64);
+    strcpy(&packet[len], "Bench");
+    strcpy(&packet[len + 18], "Benchmark node");
+    len += 18 + 64;
+    for (i = 0; i < 4; ++i) {
+        packet[len++] = 0x80 | i;       // SwIn
+    }
+    for (i = 0; i < 4; ++i) {
+        packet[len++] = 0x80 | i;       // SwOut
+    }
+    packet[len++] = 0x80;               // SubSwitch
+    packet[len++] = 0;                  // SwVideo
+    packet[len++] = 0;                  // Command - AcNone
+    return len;
+}
+
+// An RDM GET of DEVICE_INFO, without the start code
+static size_t buildRdm(char *packet, unsigned short address, const byte dest[6], const byte source[6])
+{
+    size_t len = writeHeader(packet, 0x8300);
+    byte *rdm;
+    unsigned short sum = 0xcc;
+    unsigned char i;
+    memset(&packet[len], 0, ARTNET_RDM_HEADER - len);
+    packet[12] = 1;                     // RdmVer
+    packet[21] = address >> 8;          // Net
+    packet[23] = address & 0xff;        // Address
+    rdm = (byte*)&packet[ARTNET_RDM_HEADER];
+    memset(rdm, 0, 23);
+    rdm[0] = 0x01;                      // Sub start code
+    rdm[1] = 24;                        // Message length
+    memcpy(&rdm[2], dest, 6);
+    memcpy(&rdm[8], source, 6);
+    rdm[15] = 1;                        // Port ID
+    rdm[19] = 0x20;                     // GET_COMMAND
+    rdm[21] = 0x60;                     // DEVICE_INFO
+    for (i = 0; i < 23; ++i) {
+        sum += rdm[i];
+    }
+    rdm[23] = sum >> 8;
+    rdm[24] = sum & 0xff;
+    return ARTNET_RDM_HEADER + 25;
+}
+
+// An ArtTimeCode for a frame counted from midnight
+static size_t buildTimecode(char *packet, ArtNetTimecodeType type, unsigned long frame)
+{
+    static const unsigned char fps[4] = { 24, 25, 30, 30 };
+    size_t len = writeHeader(packet, 0x9700);
+    unsigned long minutes;
+    if (type == ARTNET_TIMECODE_DF) {
+        // Back to the frame as numbered, skipping two a minute but each tenth
+        minutes = frame % 17982;
+        frame += 18 * (frame / 17982) + (minutes > 1 ? 2 * ((minutes - 2) / 1798) : 0);
+    }
+    packet[len++] = 0;                  // Filler
+    packet[len++] = 0;                  // Stream
+    packet[len++] = frame % fps[type];
+    packet[len++] = (frame / fps[type]) % 60;
+    packet[len++] = (frame / fps[type] / 60) % 60;
+    packet[len++] = frame / fps[type] / 3600;
+    packet[len++] = type;
+    return len;
+}
+
+static size_t buildIpProg(char *packet)
+{
+    size_t len = writeHeader(packet, 0xf800);
+    packet[len++] = 0;                  // Filler
+    packet[len++] = 0;                  // Filler
+    packet[len++] = (1 << 7) | (1 << 2);// Enable programming of the IP
+    packet[len++] = 0;                  // Filler
+    packet[len++] = 2;                  // ProgIp
+    packet[len++] = 0;
+    packet[len++] = 0;
+    packet[len++] = 20;
+    memset(&packet[len], 0, 4 + 2 + 8); // ProgSm, ProgPort and spare
+    len += 4 + 2 + 8;
+    return len;
+}
+
+/**************************************************************************
+ * Runner
+ **************************************************************************/
+
+static unsigned long long nowNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Packets alternate between the given number of source IPs, if sequence is
+// set then ArtDmx sequence numbers are counted up from it and if vary is set
+// the byte it points to is counted up
+static void run(ArtNetBase &node, const char *name, char *packet, size_t len, unsigned long iterations, unsigned char sources = 1, unsigned char sequence = 0, char *vary = 0)
+{
+    byte source[4] = { 2, 0, 0, 1 };
+    unsigned long long start, elapsed;
+    unsigned long i;
+    double nsPerPacket;
+
+    sendCount = 0;
+    callbackCount = 0;
+    setIPCount = 0;
+    EEPROM.resetCounters();
+
+    start = nowNanos();
+    for (i = 0; i < iterations; ++i) {
+        source[3] = 1 + (i % sources);
+        if (sequence) {
+            packet[12] = sequence;
+            sequence = sequence == 255 ? 1 : sequence + 1;
+        }
+        if (vary) {
+            (*vary)++;
+        }
+        node.ProcessPacket(source, UDP_PORT_ARTNET, packet, len);
+        node.Service();
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+
+    nsPerPacket = (double)elapsed / iterations;
+    printf("%-12s %12.0f %10.1f %10.2f %10.2f %8.2f %8.2f",
+           name,
+           1e9 / nsPerPacket,
+           nsPerPacket,
+           (double)EEPROM.reads / iterations,
+           (double)EEPROM.writes / iterations,
+           (double)sendCount / iterations,
+           (double)callbackCount / iterations);
+    if (node.GetSequenceDropCount() > staleCount) {
+        printf("  (%u stale)", node.GetSequenceDropCount() - staleCount);
+        staleCount = node.GetSequenceDropCount();
+    }
+    printf("\n");
+}
+
+// A frame is an ArtDmx for each universe, followed by an ArtSync if sync is
+// set, then a call to Service().  Figures are per frame, the last column is
+// the number of shows.
+static void runFrames(ArtNet &node, const char *name, unsigned char universes, unsigned char sync, unsigned long iterations)
+{
+    static char dmx[BENCH_MAX_UNIVERSES][600];
+    static char syncPacket[16];
+    size_t dmxLen = 0, syncLen;
+    byte source[4] = { 2, 0, 0, 1 };
+    unsigned long long start, elapsed;
+    unsigned long i;
+    unsigned char universe;
+    double nsPerFrame;
+
+    for (universe = 0; universe < universes; ++universe) {
+        dmxLen = buildDmx(dmx[universe], universe, 512);
+    }
+    syncLen = buildSync(syncPacket);
+
+    sendCount = 0;
+    callbackCount = 0;
+    showCount = 0;
+    EEPROM.resetCounters();
+
+    start = nowNanos();
+    for (i = 0; i < iterations; ++i) {
+        for (universe = 0; universe < universes; ++universe) {
+            node.ProcessPacket(source, UDP_PORT_ARTNET, dmx[universe], dmxLen);
+        }
+        if (sync) {
+            node.ProcessPacket(source, UDP_PORT_ARTNET, syncPacket, syncLen);
+        }
+        node.Service();
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+
+    nsPerFrame = (double)elapsed / iterations;
+    printf("%-12s %12.0f %10.1f %10.2f %10.2f %8.2f %8.2f  (per frame, %.2f shows)\n",
+           name,
+           1e9 / nsPerFrame,
+           nsPerFrame,
+           (double)EEPROM.reads / iterations,
+           (double)EEPROM.writes / iterations,
+           (double)sendCount / iterations,
+           (double)callbackCount / iterations,
+           (double)showCount / iterations);
+}
+
+// Calls Service() for ms milliseconds with every port transmitting, the
+// input of each port changing on every call if changing is set
+static void runTransmit(ArtNet &node, const char *name, unsigned char changing, unsigned long ms)
+{
+    static byte input[BENCH_PORTS][ARTNET_DMX_LENGTH];
+    static ArtNetTransmit *transmit[BENCH_PORTS];
+    unsigned long long start, elapsed;
+    unsigned long calls = 0;
+    unsigned char port;
+
+    for (port = 0; port < BENCH_PORTS; ++port) {
+        if (!transmit[port]) {
+            transmit[port] = new ArtNetTransmit(input[port], ARTNET_DMX_LENGTH);
+        }
+        node.PortType(port, ARTNET_OUT);
+        node.SetTransmit(port, transmit[port]);
+    }
+
+    sendCount = 0;
+    start = nowNanos();
+    do {
+        if (changing) {
+            for (port = 0; port < BENCH_PORTS; ++port) {
+                input[port][calls % ARTNET_DMX_LENGTH]++;
+            }
+        }
+        node.Service();
+        calls++;
+        elapsed = nowNanos() - start;
+    } while (elapsed < ms * 1000000ULL);
+
+    printf("%-12s %12.0f %10.1f %10s %10s %8.4f %8s  (%.0f ArtDmx/s)\n",
+           name,
+           1e9 * calls / elapsed,
+           (double)elapsed / calls,
+           "-", "-",
+           (double)sendCount / calls,
+           "-",
+           1e9 * sendCount / elapsed);
+
+    for (port = 0; port < BENCH_PORTS; ++port) {
+        node.SetTransmit(port, 0);
+        node.PortType(port, ARTNET_IN);
+    }
+}
+
+// Cycle counter where there is one, otherwise nanoseconds
+static unsigned long long nowCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return nowNanos();
+#endif
+}
+
+// Cheapest clock there is for the latency histogram, ticks are cycles on x86
+static unsigned long benchTicks()
+{
+    return (unsigned long)nowCycles();
+}
+
+// Raises a diagnostic per iteration with Service() called every eighth,
+// as a node logging from its packet loop would
+static void runDiag(ArtNet &node, const char *name, byte priority, unsigned long iterations)
+{
+    unsigned long long start, elapsed;
+    unsigned long i, queued = 0;
+
+    sendCount = 0;
+    start = nowNanos();
+    for (i = 0; i < iterations; ++i) {
+        queued += node.Diagnostic(priority, "Frame", i);
+        if ((i & 7) == 7) node.Service();
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+
+    printf("%-12s %12.0f %10.1f %10s %10s %8.4f %8s  (%lu queued, %lu sent)\n",
+           name,
+           1e9 * iterations / elapsed,
+           (double)elapsed / iterations,
+           "-", "-",
+           (double)sendCount / iterations,
+           "-",
+           queued, sendCount);
+}
+
+// ArtDmx for a port with an RDM request for it every eighth packet, while
+// the devices on its line are discovered.  Service() is timed on its own
+// as the DMX refresh must never wait for the line.
+static void runRdm(ArtNet &node, const char *name, unsigned long iterations)
+{
+    static const byte controller[6] = { 0x44, 0x59, 0, 0, 0, 1 };
+    static ArtNetRdm rdm(controller, ArtNetRdmMockStart, ArtNetRdmMockPoll);
+    static char dmx[600];
+    static char request[ARTNET_RDM_HEADER + ARTNET_RDM_PACKET];
+    unsigned long long start, elapsed, before, slowest = 0;
+    unsigned long i, discovered = 0, responses;
+    size_t dmxLen, requestLen = 0;
+    byte source[4] = { 2, 0, 0, 1 };
+    byte uid[6];
+    unsigned long hash;
+    unsigned char d, j;
+
+    ArtNetRdmMockReset();
+    // A few calls per transaction, as a UART driven line would take
+    ArtNetRdmMockSetLatency(4);
+    for (d = 0; d < BENCH_RDM_DEVICES; ++d) {
+        hash = (d + 1) * 2654435761UL;
+        uid[0] = 0x44;
+        uid[1] = 0x59 + (d & 3);
+        for (j = 0; j < 4; ++j) {
+            uid[2 + j] = hash >> (8 * j);
+        }
+        ArtNetRdmMockAdd(0, uid);
+    }
+    node.SetRdm(0, &rdm);
+    dmxLen = buildDmx(dmx, node.GetPortAddress(0), 512);
+
+    sendCount = 0;
+    callbackCount = 0;
+    start = nowNanos();
+    for (i = 0; i < iterations; ++i) {
+        node.ProcessPacket(source, UDP_PORT_ARTNET, dmx, dmxLen);
+        if ((i & 7) == 7 && rdm.GetDevices()) {
+            if (!requestLen) {
+                requestLen = buildRdm(request, node.GetPortAddress(0), rdm.GetDevice(0), controller);
+            }
+            node.ProcessPacket(source, UDP_PORT_ARTNET, request, requestLen);
+        }
+        before = nowNanos();
+        node.Service();
+        before = nowNanos() - before;
+        if (before > slowest) slowest = before;
+        if (!discovered && !rdm.Discovering()) discovered = i + 1;
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+    responses = sendCount;
+
+    printf("%-12s %12.0f %10.1f %10s %10s %8.2f %8.2f\n",
+           name,
+           1e9 * iterations / elapsed,
+           (double)elapsed / iterations,
+           "-", "-",
+           (double)sendCount / iterations,
+           (double)callbackCount / iterations);
+    printf("%-12s %u devices after %lu calls, %lu sent, slowest Service() %llu ns\n",
+           "", rdm.GetDevices(), discovered, responses, slowest);
+    node.SetRdm(0, 0);
+}
+
+// Converts a 512 channel universe (170 RGB or 128 RGBW pixels) per iteration
+static void runKernel(const char *name, ArtNetColourOrder order, const ArtNetGamma_t *gamma, unsigned long iterations)
+{
+    static byte in[ARTNET_DMX_LENGTH];
+    static byte out[ARTNET_DMX_LENGTH];
+    ArtNetPixelKernel kernel = ArtNetPixelSelect(order, gamma != 0);
+    word pixels = order == ARTNET_ORDER_RGBW ? ARTNET_DMX_LENGTH / 4 : ARTNET_DMX_LENGTH / 3;
+    word bytes = pixels * (order == ARTNET_ORDER_RGBW ? 4 : 3);
+    unsigned long long start, cycles, elapsed;
+    unsigned long i;
+    word j;
+
+    for (j = 0; j < ARTNET_DMX_LENGTH; ++j) {
+        in[j] = j * 7;
+    }
+
+    start = nowNanos();
+    cycles = nowCycles();
+    for (i = 0; i < iterations; ++i) {
+        in[0] = i;
+        kernel(out, in, pixels, gamma);
+        sink = out[i % bytes];
+    }
+    cycles = nowCycles() - cycles;
+    elapsed = nowNanos() - start;
+    if (cycles == 0) cycles = 1;
+    if (elapsed == 0) elapsed = 1;
+
+    printf("%-12s %12.0f %10.1f %10.2f\n",
+           name,
+           1e9 * iterations / elapsed,
+           (double)elapsed / iterations,
+           (double)bytes * iterations / cycles);
+}
+
+// Sends frames of BENCH_GATEWAY_UNIVERSES ArtDmx, plus an ArtPoll that is
+// replied to, over loopback to a node on the UDP backend receiving batch
+// datagrams per system call.  System calls are the backend's, per datagram.
+static void runGateway(const char *name, unsigned char batch, unsigned long frames)
+{
+    static byte tx[ARTNET_TX_SIZE];
+    static ArtNetSend_t queue[ARTNET_UDP_BATCH];
+    static char packets[ARTNET_UDP_BATCH][600];
+    static size_t lengths[ARTNET_UDP_BATCH];
+    struct mmsghdr messages[ARTNET_UDP_BATCH];
+    struct iovec vectors[ARTNET_UDP_BATCH];
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    unsigned long long start, elapsed;
+    unsigned long frame, expected, processed = 0;
+    unsigned short universe, chunk, i;
+    ArtNetUdpStats_t *stats;
+    int sender, receiver, received;
+    double seconds, calls;
+
+    ArtNet gateway(benchMac, 0, tx, sizeof(tx), benchSetIP, ArtNetUdpSend, benchCallback, BENCH_PORTS);
+    gateway.Configure(0, benchIp);
+    gateway.SetSendBatch(ArtNetUdpSendBatch, queue, ARTNET_UDP_BATCH);
+    ArtNetUdpSetBatch(batch);
+    receiver = ArtNetUdpOpen(0);
+    if (receiver < 0) {
+        printf("%-12s failed to open socket\n", name);
+        return;
+    }
+
+    sender = socket(AF_INET, SOCK_DGRAM, 0);
+    getsockname(receiver, (struct sockaddr*)&address, &addressLength);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    start = nowNanos();
+    for (frame = 0; frame < frames; ++frame) {
+        for (universe = 0; universe <= BENCH_GATEWAY_UNIVERSES; universe += chunk) {
+            // The last chunk of each frame ends with the ArtPoll
+            chunk = BENCH_GATEWAY_UNIVERSES + 1 - universe;
+            if (chunk > ARTNET_UDP_BATCH) chunk = ARTNET_UDP_BATCH;
+            for (i = 0; i < chunk; ++i) {
+                if (universe + i == BENCH_GATEWAY_UNIVERSES) {
+                    lengths[i] = buildPoll(packets[i]);
+                } else {
+                    lengths[i] = buildDmx(packets[i], universe + i, 512);
+                }
+                vectors[i].iov_base = packets[i];
+                vectors[i].iov_len = lengths[i];
+                memset(&messages[i].msg_hdr, 0, sizeof(struct msghdr));
+                messages[i].msg_hdr.msg_name = &address;
+                messages[i].msg_hdr.msg_namelen = sizeof(address);
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            sendmmsg(sender, messages, chunk, 0);
+
+            // Drain before sending more so the socket buffer never overflows
+            expected = processed + chunk;
+            while (processed < expected) {
+                received = ArtNetUdpPoll(gateway, 10);
+                if (received <= 0) break;
+                processed += received;
+            }
+        }
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+    close(sender);
+    ArtNetUdpClose();
+
+    stats = ArtNetUdpGetStats();
+    seconds = elapsed / 1e9;
+    calls = stats->recvCalls + stats->sendCalls + stats->waitCalls;
+    printf("%-12s %12.0f %10.1f %10.3f %10llu %8.2f  (%.1fx %d universes at %d Hz)\n",
+           name,
+           stats->received / seconds,
+           (double)elapsed / (stats->received ? stats->received : 1),
+           calls / (stats->received ? stats->received : 1),
+           stats->sent,
+           (double)(frames * (BENCH_GATEWAY_UNIVERSES + 1) - stats->received) / frames,
+           stats->received / seconds / ((BENCH_GATEWAY_UNIVERSES + 1) * BENCH_GATEWAY_RATE),
+           BENCH_GATEWAY_UNIVERSES, BENCH_GATEWAY_RATE);
+}
+
+static ArtNetGamma_t shardGamma;
+// Each worker's node has its own ports, so its own LEDs
+static thread_local byte shardLeds[BENCH_SHARD_UNIVERSES][ARTNET_DMX_LENGTH];
+static std::atomic<unsigned long> shardFrames;
+
+// Output of a worker's node, pixel maps the port's universe
+static void shardCallback(unsigned short port, const char *data, unsigned short length)
+{
+    static const ArtNetPixelKernel kernel = ArtNetPixelSelect(ARTNET_ORDER_GRB, 1);
+
+    kernel(shardLeds[port], (const byte*)data, length / 3, &shardGamma);
+    shardFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+// A node for the control thread or a worker, the runtime copies the
+// control node's patch into the workers
+typedef ArtNetNode<BENCH_SHARD_UNIVERSES> ShardNode;
+
+static ShardNode *buildShardNode(unsigned char index)
+{
+    static byte tx[ARTNET_SHARD_WORKERS + 1][ARTNET_TX_SIZE];
+    ShardNode *node;
+
+    node = new ShardNode(benchMac, 0, tx[index], ARTNET_TX_SIZE, benchSetIP, benchSend, shardCallback);
+    node->Configure(0, benchIp);
+    return node;
+}
+
+// Patches every port of the control node to the universes in turn
+static void patchShardNode(ShardNode *node)
+{
+    unsigned short page, address, port;
+
+    for (page = 0; page < BENCH_SHARD_UNIVERSES / ARTNET_PORTS; ++page) {
+        address = page * ARTNET_PORTS;
+        node->SetPageNet(page, address >> 8);
+        node->SetPageSubnet(page, (address >> 4) & 0x0f);
+        for (port = address; port < address + ARTNET_PORTS; ++port) {
+            node->PortType(port, ARTNET_IN);
+            node->SetInputUniverse(port, port & 0x0f);
+        }
+    }
+    node->Commit();
+}
+
+// Offers ArtDmx across BENCH_SHARD_UNIVERSES to the runtime and waits for
+// every one to be processed, returns packets/s.  Every frame should come
+// out of the worker nodes.
+static double runShards(unsigned char workers, unsigned long packets, double base)
+{
+    static char dmx[600];
+    ArtNetPacket_t packet;
+    unsigned long long start, elapsed;
+    unsigned long i;
+    unsigned short universe;
+    unsigned char w;
+    ShardNode *control, *shardNodes[ARTNET_SHARD_WORKERS];
+    ArtNetBase *nodes[ARTNET_SHARD_WORKERS];
+    double rate;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.ip[0] = 2;
+    packet.ip[3] = 1;
+    packet.port = UDP_PORT_ARTNET;
+    packet.data = dmx;
+    packet.length = buildDmx(dmx, 0, 512);
+
+    control = buildShardNode(0);
+    patchShardNode(control);
+    for (w = 0; w < workers; ++w) {
+        shardNodes[w] = buildShardNode(w + 1);
+        nodes[w] = shardNodes[w];
+    }
+    shardFrames = 0;
+    ArtNetShards shards(control, workers, nodes);
+    shards.Start();
+
+    start = nowNanos();
+    for (i = 0; i < packets; ++i) {
+        universe = i % BENCH_SHARD_UNIVERSES;
+        dmx[14] = universe & 0xff;
+        dmx[15] = universe >> 8;
+        while (!shards.Offer(&packet)) {
+            std::this_thread::yield();
+        }
+    }
+    while (shards.GetProcessedCount() < packets) {
+        std::this_thread::yield();
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+    shards.Stop();
+    for (w = 0; w < workers; ++w) {
+        delete shardNodes[w];
+    }
+    delete control;
+
+    rate = 1e9 * packets / elapsed;
+    printf("%-12u %12.0f %10.1f %10.2f %10lu\n", workers, rate, (double)elapsed / packets, base ? rate / base : 1.0, shardFrames.load());
+    return rate;
+}
+
+// ArtDmx for port 0 in turn with sACN for the same universe from a source
+// at priority 100 and another at 50, with the cost of each protocol counted
+static void runSacn(ArtNet &node, const char *name, unsigned long iterations)
+{
+    static char dmx[600], high[BENCH_SACN_SIZE], low[BENCH_SACN_SIZE];
+    static ArtNetMetrics metrics;
+    ArtNetMetrics_t snapshot;
+    byte source[4] = { 2, 0, 0, 1 };
+    size_t dmxLen, highLen, lowLen;
+    unsigned long long start, elapsed;
+    unsigned long i;
+    double nsPerPacket;
+
+    dmxLen = buildDmx(dmx, 0, 512);
+    highLen = buildSacn(high, ARTNET_SACN_UNIVERSE_OFFSET, 1, 100, 512);
+    lowLen = buildSacn(low, ARTNET_SACN_UNIVERSE_OFFSET, 2, 50, 512);
+    metrics.Reset();
+    metrics.SetClock(benchTicks);
+    node.SetMetrics(&metrics);
+    callbackCount = 0;
+
+    start = nowNanos();
+    for (i = 0; i < iterations; ++i) {
+        switch (i % 3) {
+            case 0:
+                node.ProcessPacket(source, UDP_PORT_ARTNET, dmx, dmxLen);
+                break;
+            case 1:
+                high[111]++;
+                node.ProcessPacket(source, UDP_PORT_SACN, high, highLen);
+                break;
+            default:
+                low[111]++;
+                node.ProcessPacket(source, UDP_PORT_SACN, low, lowLen);
+                break;
+        }
+        node.Service();
+    }
+    elapsed = nowNanos() - start;
+    if (elapsed == 0) elapsed = 1;
+    node.SetMetrics(0);
+    metrics.Snapshot(&snapshot);
+
+    nsPerPacket = (double)elapsed / iterations;
+    printf("%-12s %12.0f %10.1f %10s %10s %8s %8.2f  (ticks/pkt Art-Net %.0f, sACN %.0f, %lu below priority)\n",
+           name,
+           1e9 / nsPerPacket,
+           nsPerPacket,
+           "-", "-", "-",
+           (double)callbackCount / iterations,
+           (double)snapshot.protocolTicks[ARTNET_PROTOCOL_ARTNET] / snapshot.protocolPackets[ARTNET_PROTOCOL_ARTNET],
+           (double)snapshot.protocolTicks[ARTNET_PROTOCOL_SACN] / snapshot.protocolPackets[ARTNET_PROTOCOL_SACN],
+           snapshot.drops[ARTNET_DROP_PRIORITY]);
+}
+
+static unsigned long timecodeNow;
+
+static unsigned long timecodeClock()
+{
+    return timecodeNow;
+}
+
+// ArtTimeCode and an ArtDmx per frame from a source drift ppm fast, each
+// arriving up to jitter us late, with Service() every BENCH_TIMECODE_STEP
+// us of simulated time.  The spread of the intervals between outputs is
+// compared with that between arrivals.
+static void runTimecode(ArtNet &node, const char *name, ArtNetTimecodeType type, long drift, unsigned long jitter)
+{
+    static const double rates[4] = { 24.0, 25.0, 30000.0 / 1001.0, 30.0 };
+    static ArtNetSyncBuffer sync;
+    static char dmx[600], timecodePacket[32];
+    ArtNetTimecode timecode;
+    ArtNetTimecodeStats_t stats;
+    byte source[4] = { 2, 0, 0, 1 };
+    double period = 1e6 / rates[type] / (1.0 + drift / 1e6);
+    unsigned long frame = 0, first = 10UL * 3600 * 25, outputs = 0, arrivals = 0;
+    unsigned long arrival, lastArrival = 0, lastOutput = 0, shown;
+    double error, inMax = 0, outMax = 0;
+    size_t dmxLen, timecodeLen;
+
+    if (type == ARTNET_TIMECODE_FILM) first = 10UL * 3600 * 24;
+    if (type >= ARTNET_TIMECODE_DF) first = 10UL * 3600 * 30;
+    srand(1);
+    timecodeNow = 1000000;
+    timecode.SetClock(timecodeClock);
+    // Late enough that the frame has arrived however much it was delayed
+    timecode.SetOffset(jitter);
+    node.SetTimecode(&timecode);
+    node.SetSync(0, &sync);
+    dmxLen = buildDmx(dmx, node.GetPortAddress(0), 512);
+
+    arrival = timecodeNow + rand() % jitter;
+    while (frame < BENCH_TIMECODE_FRAMES) {
+        if ((long)(timecodeNow - arrival) >= 0) {
+            timecodeLen = buildTimecode(timecodePacket, type, first + frame);
+            node.ProcessPacket(source, UDP_PORT_ARTNET, timecodePacket, timecodeLen);
+            node.ProcessPacket(source, UDP_PORT_ARTNET, dmx, dmxLen);
+            // Once settled, how far each interval is from the frame period
+            error = fabs((double)(timecodeNow - lastArrival) - period);
+            if (frame > 100 && error > inMax) inMax = error;
+            lastArrival = timecodeNow;
+            arrivals++;
+            frame++;
+            arrival = 1000000 + (unsigned long)(frame * period) + rand() % jitter;
+        }
+        shown = callbackCount;
+        node.Service();
+        if (callbackCount != shown) {
+            error = fabs((double)(timecodeNow - lastOutput) - period);
+            if (frame > 100 && error > outMax) outMax = error;
+            lastOutput = timecodeNow;
+            outputs++;
+        }
+        timecodeNow += BENCH_TIMECODE_STEP;
+    }
+    timecode.Snapshot(&stats);
+
+    printf("%-12s %8lu %8lu %10ld %10.1f %10.0f %10.0f %10lu\n",
+           name, arrivals, outputs, drift, stats.drift / 1000.0, inMax, outMax, stats.jitter);
+    node.SetTimecode(0);
+    node.SetSync(0, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    static char packet[600];
+    unsigned long iterations = BENCH_DEFAULT_ITERATIONS;
+    unsigned char i;
+    size_t len;
+
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 10);
+        if (iterations == 0) iterations = 1;
+    }
+
+    EEPROM.clear();
+    ArtNet node(benchMac, 0, benchTx, sizeof(benchTx), benchSetIP, benchSend, benchCallback, BENCH_PORTS);
+    node.Configure(0, benchIp);
+    for (i = 0; i < BENCH_PORTS; ++i) {
+        node.SetInputUniverse(i, i);
+    }
+
+    printf("%lu iterations, %d ports\n", iterations, BENCH_PORTS);
+    printf("%-12s %12s %10s %10s %10s %8s %8s\n",
+           "opcode", "packets/s", "ns/packet", "ee rd/pkt", "ee wr/pkt", "tx/pkt", "cb/pkt");
+
+    len = buildDmx(packet, 0, 512);
+    run(node, "ArtDmx", packet, len, iterations);
+
+    run(node, "ArtDmx-seq", packet, len, iterations, 1, 1);
+    packet[12] = 1;
+    run(node, "ArtDmx-dup", packet, len, iterations);
+    packet[12] = 0;
+
+    len = buildDmx(packet, 0x7fff, 512);
+    run(node, "ArtDmx-miss", packet, len, iterations);
+
+    {
+        // The same traffic with every counter and the latency histogram on
+        static ArtNetMetrics metrics;
+        ArtNetPortMetrics_t<MAX_PORTS> snapshot;
+        unsigned char b, median;
+        unsigned long seen;
+
+        metrics.SetClock(benchTicks);
+        node.SetMetrics(&metrics);
+        len = buildDmx(packet, 0, 512);
+        run(node, "ArtDmx-met", packet, len, iterations);
+        node.SetMetrics(0);
+
+        metrics.Snapshot(&snapshot);
+        seen = 0;
+        for (median = 0; median < ARTNET_LATENCY_BUCKETS - 1; ++median) {
+            seen += snapshot.latency[median];
+            if (seen * 2 >= snapshot.frames[0]) break;
+        }
+        printf("%-12s %lu frames, median < %lu ticks, max %lu ticks, buckets", "", snapshot.frames[0], 1UL << median, snapshot.latencyMax);
+        for (b = 0; b < ARTNET_LATENCY_BUCKETS; ++b) {
+            if (snapshot.latency[b]) printf(" %u:%lu", b, snapshot.latency[b]);
+        }
+        printf("\n");
+    }
+
+    {
+        // The same universe over sACN, then competing with Art-Net and a
+        // lower priority sACN source
+        static char sacn[BENCH_SACN_SIZE];
+        static ArtNetSacn receiver;
+        node.SetSacn(&receiver);
+        len = buildSacn(sacn, ARTNET_SACN_UNIVERSE_OFFSET, 1, 100, 512);
+        run(node, "sACN", sacn, len, iterations, 1, 0, &sacn[111]);
+        runSacn(node, "sACN-prio", iterations);
+        printf("%-12s %u sources\n", "", receiver.GetSources());
+        node.SetSacn(0);
+    }
+
+    {
+        // A static look, then one changing channel through the range callback
+        static ArtNetChangeBuffer changes;
+        node.SetChanges(0, &changes);
+        len = buildDmx(packet, 0, 512);
+        run(node, "ArtDmx-same", packet, len, iterations);
+        node.SetRangeCallback(benchRange);
+        run(node, "ArtDmx-range", packet, len, iterations, 1, 0, &packet[18 + 100]);
+        node.SetRangeCallback(0);
+        node.SetChanges(0, 0);
+        printf("%-12s %u skipped\n", "", node.GetSkipCount());
+    }
+
+    {
+        static ArtNetMerge merge;
+        node.SetMerge(0, &merge);
+        len = buildDmx(packet, 0, 512);
+        run(node, "ArtDmx-htp", packet, len, iterations, 2);
+        merge.SetMode(ARTNET_MERGE_LTP);
+        run(node, "ArtDmx-ltp", packet, len, iterations, 2);
+        node.SetMerge(0, 0);
+    }
+
+    {
+        static ArtNetSyncBuffer sync[BENCH_PORTS];
+        for (i = 0; i < BENCH_PORTS; ++i) {
+            node.SetSync(i, &sync[i]);
+        }
+        runFrames(node, "ArtSync", BENCH_PORTS, 1, iterations / BENCH_PORTS);
+        for (i = 0; i < BENCH_PORTS; ++i) {
+            node.SetSync(i, 0);
+        }
+    }
+
+    {
+        // A strip across 6 universes of 170 pixels, shown once complete
+        static byte leds[BENCH_PIXELS * 3];
+        static ArtNetPixelMap map(leds, BENCH_PIXELS, ARTNET_ORDER_GRB, 0, 0, ARTNET_PIXEL_UNIVERSE_CHANNELS);
+        node.AddPixelMap(&map);
+        node.SetShow(benchShow, 0);
+        runFrames(node, "PixelMap", map.GetUniverses(), 0, iterations / map.GetUniverses());
+        node.SetShow(0, 0);
+    }
+
+    len = buildPoll(packet);
+    run(node, "ArtPoll", packet, len, iterations);
+
+    len = buildAddress(packet);
+    run(node, "ArtAddress", packet, len, iterations);
+
+    len = buildIpProg(packet);
+    run(node, "ArtIpProg", packet, len, iterations);
+
+    {
+        // Replies from a full table of peers, then polls from one controller
+        static ArtNetDiscovery discovery;
+        node.SetDiscovery(&discovery);
+        len = buildPollReply(packet);
+        run(node, "PollReply", packet, len, iterations, ARTNET_DISCOVERY_PEERS);
+        len = buildPoll(packet);
+        run(node, "ArtPoll-uni", packet, len, iterations);
+        printf("%-12s %u peers\n", "", discovery.Count());
+        node.SetDiscovery(0);
+    }
+
+    {
+        // A controller asking for high priority diagnostics only, the node
+        // ignores polls from its own address
+        static ArtNetDiagnostics diagnostics;
+        byte controller[4] = { 2, 0, 0, 1 };
+        node.SetDiagnostics(&diagnostics);
+        len = buildPoll(packet);
+        packet[12] = 1 << 2;
+        packet[13] = ARTNET_DIAGNOSTIC_HIGH;
+        node.ProcessPacket(controller, UDP_PORT_ARTNET, packet, len);
+        runDiag(node, "Diag-low", ARTNET_DIAGNOSTIC_LOW, iterations);
+        runDiag(node, "Diag-high", ARTNET_DIAGNOSTIC_HIGH, iterations);
+        printf("%-12s %u dropped\n", "", diagnostics.GetDropCount());
+        node.SetDiagnostics(0);
+        len = buildPoll(packet);
+        node.ProcessPacket(controller, UDP_PORT_ARTNET, packet, len);
+    }
+
+    // Service() calls rather than packets, sends are paced whatever the rate
+    runTransmit(node, "Tx-change", 1, 500);
+    runTransmit(node, "Tx-static", 0, 500);
+
+    runRdm(node, "ArtDmx-rdm", iterations);
+
+    // Foreign traffic, each would otherwise broadcast an ArtPollReply
+    len = writeHeader(packet, 0x1234);
+    run(node, "Unknown", packet, len, iterations);
+    printf("%-12s %u suppressed\n", "", node.GetPollSuppressedCount());
+
+    {
+        // A gateway of four port pages, each answering a poll with its own reply
+        static ArtNetNode<BENCH_PAGE_PORTS> gateway(benchMac, 0, benchTx, sizeof(benchTx), benchSetIP, benchSend, benchCallback);
+        static ArtNetSend_t queue[ARTNET_UDP_BATCH];
+        gateway.Configure(0, benchIp);
+        len = buildPoll(packet);
+        packet[12] = 0;
+        run(gateway, "ArtPoll-page", packet, len, iterations / 16);
+        gateway.SetSendBatch(benchSendBatch, queue, ARTNET_UDP_BATCH);
+        batchCount = 0;
+        run(gateway, "ArtPoll-batch", packet, len, iterations / 16);
+        printf("%-12s %u pages, %.2f batches per poll\n", "", gateway.GetPages(), (double)batchCount / (iterations / 16));
+    }
+
+    {
+        static ArtNetGamma_t gamma;
+        static const byte balance[4] = { 255, 224, 192, 255 };
+        ArtNetGammaBuild(&gamma, 2.2, balance);
+
+#if defined(__x86_64__) || defined(__i386__)
+        printf("\n%-12s %12s %10s %10s\n", "kernel", "universes/s", "ns/univ", "bytes/cyc");
+#else
+        printf("\n%-12s %12s %10s %10s\n", "kernel", "universes/s", "ns/univ", "bytes/ns");
+#endif
+        runKernel("RGB", ARTNET_ORDER_RGB, 0, iterations);
+        runKernel("GRB", ARTNET_ORDER_GRB, 0, iterations);
+        runKernel("BGR", ARTNET_ORDER_BGR, 0, iterations);
+        runKernel("RGBW", ARTNET_ORDER_RGBW, 0, iterations);
+        runKernel("RGB-gamma", ARTNET_ORDER_RGB, &gamma, iterations);
+        runKernel("GRB-gamma", ARTNET_ORDER_GRB, &gamma, iterations);
+        runKernel("RGBW-gamma", ARTNET_ORDER_RGBW, &gamma, iterations);
+    }
+
+    {
+        unsigned long frames = iterations / BENCH_GATEWAY_UNIVERSES;
+        if (frames == 0) frames = 1;
+        printf("\n%-12s %12s %10s %10s %10s %8s\n", "backend", "packets/s", "ns/packet", "calls/pkt", "sent", "lost/frm");
+        runGateway("UDP-single", 1, frames);
+        runGateway("UDP-batch", ARTNET_UDP_BATCH, frames);
+    }
+
+    printf("\n%-12s %8s %8s %10s %10s %10s %10s %10s\n", "timecode", "frames", "outputs", "drift ppm", "est ppm", "in err us", "out err us", "jitter us");
+    runTimecode(node, "TC-24", ARTNET_TIMECODE_FILM, 0, 8000);
+    runTimecode(node, "TC-25", ARTNET_TIMECODE_EBU, 100, 8000);
+    runTimecode(node, "TC-29.97DF", ARTNET_TIMECODE_DF, -50, 8000);
+    runTimecode(node, "TC-30", ARTNET_TIMECODE_SMPTE, 250, 2000);
+
+    {
+        static const byte balance[4] = { 255, 255, 255, 255 };
+        unsigned char workers, cores = std::thread::hardware_concurrency();
+        double base;
+
+        ArtNetGammaBuild(&shardGamma, 2.2, balance);
+        printf("\n%-12s %12s %10s %10s %10s  (%u cores, %d universes)\n", "workers", "packets/s", "ns/packet", "scaling", "output", cores, BENCH_SHARD_UNIVERSES);
+        base = runShards(1, iterations, 0);
+        for (workers = 2; workers <= ARTNET_SHARD_WORKERS && workers <= (cores > 4 ? cores : 4); workers *= 2) {
+            runShards(workers, iterations, base);
+        }
+    }
+
+    return 0;
+}
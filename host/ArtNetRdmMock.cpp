@@ -0,0 +1,239 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "ArtNetRdmMock.h"
+
+typedef struct MockDeviceTag
+{
+    byte uid[6];
+    unsigned char muted;
+} MockDevice_t;
+
+typedef struct MockLineTag
+{
+    MockDevice_t devices[ARTNET_RDM_MOCK_DEVICES];
+    unsigned char count;
+    // The transaction on the line
+    unsigned char active;
+    unsigned char polls;
+    byte request[ARTNET_RDM_PACKET];
+    word length;
+} MockLine_t;
+
+static MockLine_t mockLines[ARTNET_RDM_MOCK_PORTS];
+static unsigned char mockLatency = 1;
+static ArtNetRdmMockStats_t mockStats;
+
+static unsigned long long mockUid(const byte *uid)
+{
+    unsigned long long value = 0;
+    unsigned char i;
+    for (i = 0; i < 6; ++i) {
+        value = (value << 8) | uid[i];
+    }
+    return value;
+}
+
+static unsigned short mockChecksum(const byte *data, word length)
+{
+    // From the start code, which isn't in the data
+    unsigned short sum = 0xcc;
+    word i;
+    for (i = 0; i < length; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+// A response from device to the request, with no parameter data
+static word mockRespond(const MockDevice_t *device, const byte *request, byte *response)
+{
+    unsigned short sum;
+
+    response[0] = 0x01;
+    response[1] = 24;
+    memcpy(&response[2], &request[8], 6);       // Back to the controller
+    memcpy(&response[8], device->uid, 6);
+    response[14] = request[14];                 // Transaction number
+    response[15] = 0x00;                        // RESPONSE_TYPE_ACK
+    response[16] = 0;                           // Message count
+    response[17] = request[17];                 // Sub-device
+    response[18] = request[18];
+    response[19] = request[19] + 1;             // Command class response
+    response[20] = request[20];
+    response[21] = request[21];
+    response[22] = 0;
+    sum = mockChecksum(response, 23);
+    response[23] = sum >> 8;
+    response[24] = sum & 0xff;
+    mockStats.responses++;
+    return 25;
+}
+
+// The DISC_UNIQUE_BRANCH response of a single device
+static word mockBranchResponse(const MockDevice_t *device, byte *response)
+{
+    unsigned short sum = 0;
+    unsigned char i;
+
+    memset(response, 0xfe, 7);
+    response[7] = 0xaa;
+    for (i = 0; i < 6; ++i) {
+        response[8 + 2 * i] = device->uid[i] | 0xaa;
+        response[8 + 2 * i + 1] = device->uid[i] | 0x55;
+        sum += response[8 + 2 * i] + response[8 + 2 * i + 1];
+    }
+    response[20] = (sum >> 8) | 0xaa;
+    response[21] = (sum >> 8) | 0x55;
+    response[22] = (sum & 0xff) | 0xaa;
+    response[23] = (sum & 0xff) | 0x55;
+    return 24;
+}
+
+void ArtNetRdmMockReset()
+{
+    memset(mockLines, 0, sizeof(mockLines));
+    memset(&mockStats, 0, sizeof(mockStats));
+    mockLatency = 1;
+}
+
+unsigned char ArtNetRdmMockAdd(unsigned short port, const byte uid[6])
+{
+    MockLine_t *line;
+
+    if (port >= ARTNET_RDM_MOCK_PORTS) return 0;
+    line = &mockLines[port];
+    if (line->count == ARTNET_RDM_MOCK_DEVICES) return 0;
+    memcpy(line->devices[line->count].uid, uid, 6);
+    line->devices[line->count].muted = 0;
+    line->count++;
+    return 1;
+}
+
+void ArtNetRdmMockSetLatency(unsigned char polls)
+{
+    mockLatency = polls;
+}
+
+unsigned char ArtNetRdmMockStart(unsigned short port, const byte *request, word length)
+{
+    MockLine_t *line;
+
+    if (port >= ARTNET_RDM_MOCK_PORTS || length > ARTNET_RDM_PACKET) return 0;
+    line = &mockLines[port];
+    if (line->active) return 0;
+    memcpy(line->request, request, length);
+    line->length = length;
+    line->polls = mockLatency;
+    line->active = 1;
+    mockStats.requests++;
+    return 1;
+}
+
+ArtNetRdmResult ArtNetRdmMockPoll(unsigned short port, byte *response, word *length)
+{
+    MockLine_t *line;
+    const byte *request;
+    unsigned long long dest, lower, upper, uid;
+    unsigned short pid, sum;
+    unsigned char i, broadcast, matched;
+    MockDevice_t *device = 0;
+
+    if (port >= ARTNET_RDM_MOCK_PORTS) return ARTNET_RDM_NONE;
+    line = &mockLines[port];
+    if (!line->active) return ARTNET_RDM_NONE;
+    if (line->polls > 1) {
+        line->polls--;
+        return ARTNET_RDM_PENDING;
+    }
+    line->active = 0;
+    request = line->request;
+
+    // Devices ignore anything with a bad checksum
+    if (line->length < 25 || line->length != request[1] + 1U) {
+        mockStats.checksumErrors++;
+        return ARTNET_RDM_NONE;
+    }
+    sum = mockChecksum(request, line->length - 2);
+    if (request[line->length - 2] != (sum >> 8) || request[line->length - 1] != (sum & 0xff)) {
+        mockStats.checksumErrors++;
+        return ARTNET_RDM_NONE;
+    }
+
+    dest = mockUid(&request[2]);
+    broadcast = (dest & 0xffffffffULL) == 0xffffffffULL;
+    pid = (request[20] << 8) | request[21];
+    for (i = 0; i < line->count; ++i) {
+        if (mockUid(line->devices[i].uid) == dest) {
+            device = &line->devices[i];
+            break;
+        }
+    }
+
+    if (request[19] != 0x10) {
+        // GET or SET, only unicast is answered
+        if (!device || broadcast) return ARTNET_RDM_NONE;
+        *length = mockRespond(device, request, response);
+        return ARTNET_RDM_RESPONSE;
+    }
+
+    switch (pid) {
+        case 0x0001:
+            // DISC_UNIQUE_BRANCH, every unmuted device in the range answers
+            mockStats.branches++;
+            lower = mockUid(&request[23]);
+            upper = mockUid(&request[29]);
+            matched = 0;
+            for (i = 0; i < line->count; ++i) {
+                uid = mockUid(line->devices[i].uid);
+                if (!line->devices[i].muted && uid >= lower && uid <= upper) {
+                    device = &line->devices[i];
+                    matched++;
+                }
+            }
+            if (matched == 0) return ARTNET_RDM_NONE;
+            if (matched > 1) {
+                mockStats.collisions++;
+                return ARTNET_RDM_COLLISION;
+            }
+            *length = mockBranchResponse(device, response);
+            return ARTNET_RDM_RESPONSE;
+        case 0x0002:
+        case 0x0003:
+            // DISC_MUTE and DISC_UN_MUTE
+            if (broadcast) {
+                for (i = 0; i < line->count; ++i) {
+                    line->devices[i].muted = pid == 0x0002;
+                }
+                return ARTNET_RDM_NONE;
+            }
+            if (!device) return ARTNET_RDM_NONE;
+            device->muted = pid == 0x0002;
+            *length = mockRespond(device, request, response);
+            return ARTNET_RDM_RESPONSE;
+    }
+    return ARTNET_RDM_NONE;
+}
+
+ArtNetRdmMockStats_t *ArtNetRdmMockGetStats()
+{
+    return &mockStats;
+}
@@ -0,0 +1,61 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * Mock RDM backend for ArtNetRdm.  Each port has a line of simulated
+ * responders that answer discovery, mute and GET/SET requests as real
+ * devices would, with overlapping discovery responses reported as
+ * collisions.  Transactions take a set number of calls to poll() so that
+ * the node sees them complete asynchronously.
+ */
+
+#ifndef ARTNET_RDM_MOCK_H
+#define ARTNET_RDM_MOCK_H
+
+#include <Arduino.h>
+#include <ArtNetRdm.h>
+
+// Lines simulated, one per port
+#define ARTNET_RDM_MOCK_PORTS 4
+// Devices on each line
+#define ARTNET_RDM_MOCK_DEVICES 64
+
+typedef struct ArtNetRdmMockStatsTag
+{
+    unsigned long requests;
+    unsigned long branches;
+    unsigned long collisions;
+    unsigned long responses;
+    unsigned long checksumErrors;
+} ArtNetRdmMockStats_t;
+
+// Removes every device, resets the stats and any transaction
+void ArtNetRdmMockReset();
+// Adds a device to the line of a port, returns 0 if there is no room
+unsigned char ArtNetRdmMockAdd(unsigned short port, const byte uid[6]);
+// Calls to poll() before a transaction completes, 1 by default
+void ArtNetRdmMockSetLatency(unsigned char polls);
+// Backend functions for the ArtNetRdm constructor
+unsigned char ArtNetRdmMockStart(unsigned short port, const byte *request, word length);
+ArtNetRdmResult ArtNetRdmMockPoll(unsigned short port, byte *response, word *length);
+ArtNetRdmMockStats_t *ArtNetRdmMockGetStats();
+
+#endif
@@ -0,0 +1,337 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetShards.h"
+
+// Op codes the receive thread classifies by, little endian on the wire
+#define ARTNET_SHARD_OP_DMX  0x5000
+#define ARTNET_SHARD_OP_SYNC 0x5200
+#define ARTNET_SHARD_OP_ADDRESS 0x6000
+#define ARTNET_SHARD_OP_INPUT 0x7000
+#define ARTNET_SHARD_OP_TOD_REQUEST 0x8000
+#define ARTNET_SHARD_OP_TOD_CONTROL 0x8200
+#define ARTNET_SHARD_OP_RDM 0x8300
+#define ARTNET_SHARD_OP_TIMECODE 0x9700
+// Bytes before the data in an ArtDmx
+#define ARTNET_SHARD_DMX_HEADER 18
+// Bytes up to the Port-Address of an ArtRdm or ArtTodControl
+#define ARTNET_SHARD_RDM_HEADER 24
+// Oldest protocol version accepted, as by the node
+#define ARTNET_SHARD_PROTOCOL 14
+// Empty polls before an idle thread gives up its time slice
+#define ARTNET_SHARD_SPIN 64
+
+ArtNetShardRing::ArtNetShardRing() : head(0), tail(0)
+{
+}
+
+ArtNetShardPacket_t *ArtNetShardRing::Reserve()
+{
+    unsigned int t = this->tail.load(std::memory_order_relaxed);
+    if (t - this->head.load(std::memory_order_acquire) == ARTNET_SHARD_RING) {
+        return 0;
+    }
+    return &this->slots[t & (ARTNET_SHARD_RING - 1)];
+}
+
+void ArtNetShardRing::Publish()
+{
+    this->tail.store(this->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+ArtNetShardPacket_t *ArtNetShardRing::Peek()
+{
+    unsigned int h = this->head.load(std::memory_order_relaxed);
+    if (h == this->tail.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    return &this->slots[h & (ARTNET_SHARD_RING - 1)];
+}
+
+void ArtNetShardRing::Release()
+{
+    this->head.store(this->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// The op code of an Art-Net packet, or 0 for anything else
+static unsigned short shardOpcode(const byte *data, word length)
+{
+    if (length < 12 || memcmp(data, "Art-Net", 8) != 0 || data[11] < ARTNET_SHARD_PROTOCOL) {
+        return 0;
+    }
+    return data[8] | (data[9] << 8);
+}
+
+ArtNetShards::ArtNetShards(ArtNetBase *control, unsigned char workers, ArtNetBase **nodes)
+{
+    unsigned short port;
+    unsigned char i;
+
+    if (workers < 1) workers = 1;
+    if (workers > ARTNET_SHARD_WORKERS) workers = ARTNET_SHARD_WORKERS;
+    this->control = control;
+    this->workers = workers;
+    for (i = 0; i < ARTNET_SHARD_WORKERS; ++i) {
+        this->nodes[i] = i < workers ? nodes[i] : 0;
+        this->workerRings[i] = i < workers ? new ArtNetShardRing() : 0;
+        this->processed[i] = 0;
+    }
+    this->controlRing = new ArtNetShardRing();
+    this->status = new std::atomic<unsigned char>[control->GetPorts()];
+    for (port = 0; port < control->GetPorts(); ++port) {
+        this->status[port] = 0;
+    }
+    this->running = false;
+    this->dropped = 0;
+}
+
+ArtNetShards::~ArtNetShards()
+{
+    unsigned char i;
+
+    this->Stop();
+    for (i = 0; i < this->workers; ++i) {
+        delete this->workerRings[i];
+    }
+    delete this->controlRing;
+    delete[] this->status;
+}
+
+void ArtNetShards::Start()
+{
+    unsigned char i;
+
+    if (this->running) return;
+    for (i = 0; i < this->workers; ++i) {
+        this->replicate(this->nodes[i]);
+    }
+    this->running = true;
+    for (i = 0; i < this->workers; ++i) {
+        this->workerThreads[i] = std::thread(&ArtNetShards::work, this, i);
+    }
+    this->controlThread = std::thread(&ArtNetShards::serviceControl, this);
+}
+
+void ArtNetShards::Stop()
+{
+    unsigned char i;
+
+    if (!this->running) return;
+    this->running = false;
+    for (i = 0; i < this->workers; ++i) {
+        this->workerThreads[i].join();
+    }
+    this->controlThread.join();
+}
+
+void ArtNetShards::replicate(ArtNetBase *node)
+{
+    ArtNetBase *control = this->control;
+    unsigned short i;
+
+    node->SetReplica(1);
+    for (i = 0; i < control->GetPages(); ++i) {
+        node->SetPageNet(i, control->GetPageNet(i));
+        node->SetPageSubnet(i, control->GetPageSubnet(i));
+    }
+    for (i = 0; i < control->GetPorts(); ++i) {
+        node->PortType(i, control->PortType(i));
+        node->SetInputUniverse(i, control->GetInputUniverse(i));
+        node->SetOutputUniverse(i, control->GetOutputUniverse(i));
+    }
+    node->Commit();
+}
+
+unsigned char ArtNetShards::Worker(unsigned short address)
+{
+    // Blocks of four universes, a page of a worker's node, go to each worker
+    // in turn to spread the load
+    return (address / ARTNET_PORTS) % this->workers;
+}
+
+unsigned char ArtNetShards::push(ArtNetShardRing *ring, const ArtNetPacket_t *packet)
+{
+    ArtNetShardPacket_t *slot = ring->Reserve();
+
+    if (!slot) return 0;
+    memcpy(slot->ip, packet->ip, 4);
+    slot->port = packet->port;
+    slot->length = packet->length;
+    memcpy(slot->data, packet->data, packet->length);
+    ring->Publish();
+    return 1;
+}
+
+unsigned char ArtNetShards::pushAll(unsigned char control, const ArtNetPacket_t *packet)
+{
+    unsigned char i;
+
+    // All or nothing, retrying a partial delivery would repeat it to the
+    // threads that took it
+    if (control && !this->controlRing->Reserve()) return 0;
+    for (i = 0; i < this->workers; ++i) {
+        if (!this->workerRings[i]->Reserve()) return 0;
+    }
+    if (control) this->push(this->controlRing, packet);
+    for (i = 0; i < this->workers; ++i) {
+        this->push(this->workerRings[i], packet);
+    }
+    return 1;
+}
+
+unsigned char ArtNetShards::Offer(const ArtNetPacket_t *packet)
+{
+    const byte *data = (const byte*)packet->data;
+    unsigned short opcode, address;
+
+    if (packet->length > ARTNET_SHARD_PACKET) {
+        // Too big to be anything we handle, dropped rather than retried
+        this->dropped++;
+        return 1;
+    }
+
+    // Anything not Art-Net is left to the control node to count or drop
+    opcode = shardOpcode(data, packet->length);
+    if (opcode == ARTNET_SHARD_OP_DMX && packet->length >= ARTNET_SHARD_DMX_HEADER) {
+        address = ((data[15] & 0x7f) << 8) | data[14];
+        return this->push(this->workerRings[this->Worker(address)], packet);
+    }
+
+    switch (opcode) {
+        case ARTNET_SHARD_OP_SYNC:
+        case ARTNET_SHARD_OP_TIMECODE:
+        case ARTNET_SHARD_OP_TOD_REQUEST:
+            // Every worker commits, clocks and answers for its own universes
+            return this->pushAll(0, packet);
+        case ARTNET_SHARD_OP_ADDRESS:
+        case ARTNET_SHARD_OP_INPUT:
+            // Re-patch the replicas along with the control node that replies
+            return this->pushAll(1, packet);
+        case ARTNET_SHARD_OP_RDM:
+        case ARTNET_SHARD_OP_TOD_CONTROL:
+            if (packet->length < ARTNET_SHARD_RDM_HEADER) break;
+            address = ((data[21] & 0x7f) << 8) | data[23];
+            return this->push(this->workerRings[this->Worker(address)], packet);
+    }
+
+    return this->push(this->controlRing, packet);
+}
+
+void ArtNetShards::Receive(const ArtNetPacket_t *packets, unsigned short count)
+{
+    unsigned short i;
+
+    for (i = 0; i < count; ++i) {
+        if (!this->Offer(&packets[i])) {
+            this->dropped++;
+        }
+    }
+}
+
+void ArtNetShards::work(unsigned char worker)
+{
+    ArtNetShardRing *ring = this->workerRings[worker];
+    ArtNetBase *node = this->nodes[worker];
+    ArtNetShardPacket_t *packet;
+    unsigned long serviced = millis();
+    unsigned int idle = 0;
+
+    while (this->running.load(std::memory_order_relaxed)) {
+        packet = ring->Peek();
+        if (packet) {
+            idle = 0;
+            node->ProcessPacket(packet->ip, packet->port, packet->data, packet->length);
+            ring->Release();
+            this->processed[worker].fetch_add(1, std::memory_order_relaxed);
+        } else if (++idle > ARTNET_SHARD_SPIN) {
+            std::this_thread::yield();
+        }
+
+        // Shows and the ArtSync timeout of the worker's own ports
+        if (millis() - serviced >= ARTNET_SHARD_SERVICE) {
+            serviced = millis();
+            node->Service();
+            this->publishStatus(worker);
+        }
+    }
+}
+
+void ArtNetShards::serviceControl()
+{
+    ArtNetShardPacket_t *packet;
+    unsigned long serviced = millis();
+    unsigned int idle = 0;
+
+    while (this->running.load(std::memory_order_relaxed)) {
+        packet = this->controlRing->Peek();
+        if (packet) {
+            idle = 0;
+            this->control->ProcessPacket(packet->ip, packet->port, packet->data, packet->length);
+            this->controlRing->Release();
+        } else if (++idle > ARTNET_SHARD_SPIN) {
+            std::this_thread::yield();
+        }
+
+        if (millis() - serviced >= ARTNET_SHARD_SERVICE) {
+            serviced = millis();
+            this->mirrorStatus();
+            this->control->Service();
+        }
+    }
+}
+
+void ArtNetShards::publishStatus(unsigned char worker)
+{
+    ArtNetBase *node = this->nodes[worker];
+    unsigned short i;
+
+    // The replica's patch is its own to read, and matches the control node's
+    // once any ArtAddress has reached both
+    for (i = 0; i < node->GetPorts(); ++i) {
+        if (this->Worker(node->GetPortAddress(i)) == worker) {
+            this->status[i].store(node->ArtNetPorts[i].outputStatus, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ArtNetShards::mirrorStatus()
+{
+    unsigned short i;
+
+    for (i = 0; i < this->control->GetPorts(); ++i) {
+        this->control->setOutputStatus(i, this->status[i].load(std::memory_order_relaxed));
+    }
+}
+
+unsigned long long ArtNetShards::GetProcessedCount()
+{
+    unsigned long long total = 0;
+    unsigned char i;
+
+    for (i = 0; i < this->workers; ++i) {
+        total += this->processed[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+unsigned long long ArtNetShards::GetDropCount()
+{
+    return this->dropped;
+}
@@ -0,0 +1,123 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Multi-threaded runtime for a host gateway.  The receive thread classifies
+ * datagrams and hands them over lock-free single producer, single consumer
+ * rings.  ArtDmx goes to one of several worker threads chosen by its
+ * Port-Address.  Each worker runs a replica of the control node with the
+ * same patch, and is only given the ArtDmx for the universes it owns, so
+ * sequence numbers, merging, ArtSync and output for them go through the
+ * usual dispatch path with no locking.  ArtAddress and ArtInput go to the
+ * control node and every replica so that they stay patched alike, while
+ * polls and the rest are answered by the control node alone.  The control
+ * node's poll replies carry the output status the workers publish.
+ */
+
+#ifndef ARTNET_SHARDS_H
+#define ARTNET_SHARDS_H
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <atomic>
+#include <thread>
+
+// Most worker threads
+#define ARTNET_SHARD_WORKERS 16
+// Slots in each ring, a power of two
+#define ARTNET_SHARD_RING 256
+// Largest datagram carried by a ring, anything longer is dropped
+#define ARTNET_SHARD_PACKET 640
+// Milliseconds between calls to the control node's Service()
+#define ARTNET_SHARD_SERVICE 1
+
+typedef struct ArtNetShardPacketTag
+{
+    byte ip[4];
+    word port;
+    word length;
+    char data[ARTNET_SHARD_PACKET];
+} ArtNetShardPacket_t;
+
+// Single producer, single consumer ring of packets.  Each index is only
+// written by one side and lives on its own cache line.
+class ArtNetShardRing
+{
+  private:
+    alignas(64) std::atomic<unsigned int> head;
+    alignas(64) std::atomic<unsigned int> tail;
+    alignas(64) ArtNetShardPacket_t slots[ARTNET_SHARD_RING];
+
+  public:
+    ArtNetShardRing();
+    // Producer: the slot to fill, NULL if the ring is full
+    ArtNetShardPacket_t *Reserve();
+    void Publish();
+    // Consumer: the oldest packet, NULL if the ring is empty
+    ArtNetShardPacket_t *Peek();
+    void Release();
+};
+
+class ArtNetShards
+{
+  private:
+    ArtNetBase *control;
+    unsigned char workers;
+    ArtNetBase *nodes[ARTNET_SHARD_WORKERS];
+    ArtNetShardRing *workerRings[ARTNET_SHARD_WORKERS];
+    ArtNetShardRing *controlRing;
+    std::thread workerThreads[ARTNET_SHARD_WORKERS];
+    std::thread controlThread;
+    std::atomic<bool> running;
+    std::atomic<unsigned long long> processed[ARTNET_SHARD_WORKERS];
+    // Output status of each port, published by the worker that owns it
+    std::atomic<unsigned char> *status;
+    unsigned long long dropped;
+
+  public:
+    // nodes[w] is given each ArtDmx for the universes worker w owns, see
+    // Worker(), and every ArtSync.  Start() copies the control node's patch
+    // into it and makes it a replica, after which a node is only touched by
+    // its thread.  The control node and the worker nodes must have the same
+    // number of ports and outlive the runtime.
+    ArtNetShards(ArtNetBase *control, unsigned char workers, ArtNetBase **nodes);
+    ~ArtNetShards();
+    void Start();
+    void Stop();
+    // The worker that owns a Port-Address
+    unsigned char Worker(unsigned short address);
+    // Receive thread only.  Hands one datagram over, returns 0 if its ring
+    // was full so that it can be retried.
+    unsigned char Offer(const ArtNetPacket_t *packet);
+    // Receive thread only.  Hands datagrams over, dropping any that don't fit.
+    void Receive(const ArtNetPacket_t *packets, unsigned short count);
+    unsigned long long GetProcessedCount();
+    unsigned long long GetDropCount();
+  private:
+    unsigned char push(ArtNetShardRing *ring, const ArtNetPacket_t *packet);
+    unsigned char pushAll(unsigned char control, const ArtNetPacket_t *packet);
+    void replicate(ArtNetBase *node);
+    void publishStatus(unsigned char worker);
+    void mirrorStatus();
+    void work(unsigned char worker);
+    void serviceControl();
+};
+
+#endif
@@ -0,0 +1,601 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Host regression checks for the packet paths.  Each check drives a node
+ * through ProcessPacket with a hand built packet and looks at what came out
+ * of the callbacks.
+ *
+ * Usage: ArtNetTest, exits non-zero if any check fails
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ArtNet.h>
+#include <ArtNetChange.h>
+#include <ArtNetDiagnostics.h>
+#include <ArtNetDiscovery.h>
+#include <ArtNetMerge.h>
+#include <ArtNetMetrics.h>
+#include <ArtNetPixelMap.h>
+#include <ArtNetSync.h>
+#include <ArtNetTransmit.h>
+#include <stdio.h>
+#include "ArtNetShards.h"
+
+static byte testMac[] = { 0x74, 0x69, 0x69, 0x2D, 0x30, 0x33 };
+static byte testIp[] = { 2, 0, 0, 10 };
+static byte testSource[] = { 2, 0, 0, 1 };
+static byte testTx[ARTNET_TX_SIZE];
+
+static unsigned int failures;
+static unsigned long callbacks;
+static unsigned short lastLength;
+static unsigned long sends;
+static byte lastDestination[4];
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    if (ok) return;
+    printf("line %d: %s\n", line, what);
+    failures++;
+}
+
+static void testSetIP(IPConfiguration, const char *, const char *)
+{
+}
+
+static void testSend(const byte *, size_t, word, byte *dip, word)
+{
+    memcpy(lastDestination, dip, 4);
+    sends++;
+}
+
+static void testCallback(unsigned short, const char *, unsigned short length)
+{
+    lastLength = length;
+    callbacks++;
+}
+
+static void testRange(unsigned short, const char *, unsigned short start, unsigned short length)
+{
+    lastLength = start + length;
+    callbacks++;
+}
+
+static size_t writeHeader(char *packet, unsigned short opcode)
+{
+    memcpy(packet, "Art-Net", 8);
+    packet[8] = opcode & 0xff;
+    packet[9] = opcode >> 8;
+    packet[10] = 0;
+    packet[11] = 14;
+    return 12;
+}
+
+// An ArtDmx claiming length channels, carrying as many as fit
+static size_t buildDmx(char *packet, unsigned short address, unsigned short length, unsigned short carried)
+{
+    size_t len = writeHeader(packet, 0x5000);
+    unsigned short i;
+    packet[len++] = 0;
+    packet[len++] = 0;
+    packet[len++] = address & 0xff;
+    packet[len++] = address >> 8;
+    packet[len++] = length >> 8;
+    packet[len++] = length & 0xff;
+    for (i = 0; i < carried; ++i) {
+        packet[len++] = i & 0xff;
+    }
+    return len;
+}
+
+// An ArtDmx longer than a universe is cut to one, with or without change
+// detection, rather than overrunning or never finishing
+static void testOversizedDmx()
+{
+    static char packet[700];
+    static ArtNetChangeBuffer changes;
+    size_t len = buildDmx(packet, 0, 600, 600);
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetInputUniverse(0, 0);
+
+    callbacks = 0;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(callbacks == 1 && lastLength == ARTNET_DMX_LENGTH);
+
+    node.SetChanges(0, &changes);
+    packet[18] ^= 1;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(callbacks == 2 && lastLength == ARTNET_DMX_LENGTH);
+
+    node.SetRangeCallback(testRange);
+    packet[18 + 511] ^= 1;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(callbacks == 3 && lastLength == ARTNET_DMX_LENGTH);
+    node.SetChanges(0, 0);
+}
+
+// A strip held back by ArtSync only changes when the frame is committed,
+// and one too long for the universes it may span reports what it maps
+static void testPixelSync()
+{
+    static char packet[32];
+    static byte leds[3 * 3];
+    static byte longLeds[6000 * 3];
+    static ArtNetSyncBuffer sync;
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetInputUniverse(0, 0);
+    node.SetSync(0, &sync);
+    ArtNetPixelMap map(leds, 3, ARTNET_ORDER_RGB, 0, 0, ARTNET_PIXEL_UNIVERSE_CHANNELS);
+    node.AddPixelMap(&map, 0);
+
+    len = writeHeader(packet, 0x5200);
+    packet[len++] = 0;
+    packet[len++] = 0;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+
+    len = buildDmx(packet, 0, 9, 9);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(leds[8] == 0);
+
+    len = writeHeader(packet, 0x5200);
+    packet[len++] = 0;
+    packet[len++] = 0;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(leds[8] == 8);
+
+    ArtNetPixelMap longMap(longLeds, 6000, ARTNET_ORDER_RGB, 0, 0, ARTNET_PIXEL_UNIVERSE_CHANNELS);
+    CHECK(longMap.GetUniverses() == ARTNET_PIXEL_MAX_UNIVERSES);
+    CHECK(longMap.GetPixels() == ARTNET_PIXEL_MAX_UNIVERSES * ARTNET_PIXEL_UNIVERSE_CHANNELS / 3);
+}
+
+// Frames staged for an ArtSync that never came go out when the node falls
+// back to immediate mode, not with a later ArtSync
+static void testSyncTimeout()
+{
+    static char packet[600];
+    static ArtNetSyncBuffer sync[2];
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 2);
+    node.Configure(0, testIp);
+    node.PortType(1, ARTNET_IN);
+    node.SetInputUniverse(0, 0);
+    node.SetInputUniverse(1, 1);
+    node.SetSync(0, &sync[0]);
+    node.SetSync(1, &sync[1]);
+    callbacks = 0;
+
+    len = writeHeader(packet, 0x5200);
+    packet[len++] = 0;
+    packet[len++] = 0;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    len = buildDmx(packet, 0, 512, 512);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    len = buildDmx(packet, 1, 512, 512);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(callbacks == 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(ARTNET_SYNC_TIMEOUT + 10));
+    len = buildDmx(packet, 0, 512, 512);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(!sync[1].Pending());
+    CHECK(callbacks == 3);
+
+    len = writeHeader(packet, 0x5200);
+    packet[len++] = 0;
+    packet[len++] = 0;
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(callbacks == 3);
+}
+
+// Frames are counted per port for every port of the node, and a frame
+// skipped as unchanged isn't counted as output
+static void testMetricsPorts()
+{
+    static char packet[600];
+    static ArtNetChangeBuffer changes;
+    static ArtNetPortMetrics<8> metrics;
+    ArtNetPortMetrics_t<8> snapshot;
+    size_t len = buildDmx(packet, 5, 512, 512);
+
+    ArtNetNode<8> node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 8);
+    node.Configure(0, testIp);
+    node.SetInputUniverse(5, 5);
+    node.SetChanges(5, &changes);
+    node.SetMetrics(&metrics);
+
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    node.SetMetrics(0);
+    metrics.Snapshot(&snapshot);
+    CHECK(snapshot.frames[5] == 1);
+    CHECK(snapshot.frames[0] == 0);
+    CHECK(snapshot.opcodes[ARTNET_METRIC_DMX] == 2);
+}
+
+// LTP takes each channel from the source that last changed it, not the
+// whole of the latest frame
+static void testMergeLtp()
+{
+    static ArtNetMerge merge;
+    byte a[4] = { 2, 0, 0, 1 }, b[4] = { 2, 0, 0, 2 }, c[4] = { 2, 0, 0, 3 };
+    byte frameA[3] = { 10, 10, 10 }, frameB[3] = { 20, 20, 20 };
+    const byte *out;
+    word length;
+
+    merge.SetMode(ARTNET_MERGE_LTP);
+    merge.Merge(a, 0, frameA, 3, &length);
+    out = merge.Merge(b, 0, frameB, 3, &length);
+    CHECK(merge.IsMerging() && out[0] == 20 && out[2] == 20);
+
+    frameA[1] = 30;
+    out = merge.Merge(a, 0, frameA, 3, &length);
+    CHECK(out[0] == 20 && out[1] == 30 && out[2] == 20);
+
+    frameB[2] = 40;
+    out = merge.Merge(b, 0, frameB, 3, &length);
+    CHECK(out[0] == 20 && out[1] == 30 && out[2] == 40 && length == 3);
+
+    CHECK(merge.Merge(c, 0, frameA, 3, &length) == 0);
+}
+
+// Two physical ports of one node are separate sources, and the merge ends
+// once they stop sending even if no more ArtDmx arrives
+static void testMergeSources()
+{
+    static ArtNetMerge merge;
+    byte a[4] = { 2, 0, 0, 1 };
+    byte frameA[3] = { 10, 10, 10 }, frameB[3] = { 20, 20, 20 };
+    word length;
+
+    merge.Merge(a, 0, frameA, 3, &length);
+    merge.Merge(a, 1, frameB, 3, &length);
+    CHECK(merge.IsMerging());
+    CHECK(!merge.Service(millis()));
+    CHECK(merge.Service(millis() + ARTNET_MERGE_TIMEOUT + 1));
+    CHECK(!merge.IsMerging());
+}
+
+// An ArtInput for the page with bind index, disabling the inputs in mask
+static size_t buildInput(char *packet, byte bindIndex, byte mask)
+{
+    size_t len = writeHeader(packet, 0x7000);
+    unsigned char i;
+    packet[len++] = 0;                  // Filler
+    packet[len++] = bindIndex;
+    packet[len++] = 0;
+    packet[len++] = ARTNET_PORTS;
+    for (i = 0; i < ARTNET_PORTS; ++i) {
+        packet[len++] = (mask >> i) & 1;
+    }
+    return len;
+}
+
+// ArtInput is routed by its bind index to the page of four ports it names
+static void testInputBindIndex()
+{
+    static char packet[32];
+    size_t len;
+
+    ArtNetNode<12> node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback);
+    node.Configure(0, testIp);
+    node.PortType(0, ARTNET_IN);
+    node.PortType(4, ARTNET_IN);
+    node.PortType(8, ARTNET_IN);
+
+    len = buildInput(packet, 2, 1);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(!node.InputDisabled(0));
+    CHECK(node.InputDisabled(4));
+    CHECK(!node.InputDisabled(8));
+    CHECK(node.PortType(4) == ARTNET_IN);
+
+    // Bind index 0 is the same as 1, the first page
+    len = buildInput(packet, 0, 1);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(node.InputDisabled(0));
+
+    // Enabled again, and a page that doesn't exist is ignored
+    len = buildInput(packet, 2, 0);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(!node.InputDisabled(4));
+    len = buildInput(packet, 4, 1);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(!node.InputDisabled(8));
+
+    // A transmitting port stays one, only sending while its input is on
+    static byte input[ARTNET_DMX_LENGTH];
+    static ArtNetTransmit transmit(input, sizeof(input));
+    node.PortType(0, ARTNET_OUT);
+    node.SetTransmit(0, &transmit);
+    // Past the spacing the transmitter keeps from millis() 0
+    while (millis() <= ARTNET_TRANSMIT_SPACING);
+    sends = 0;
+    node.Service();
+    CHECK(sends == 0);
+    len = buildInput(packet, 1, 0);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(node.PortType(0) == ARTNET_OUT && !node.InputDisabled(0));
+    sends = 0;
+    node.Service();
+    CHECK(sends == 1);
+    node.SetTransmit(0, 0);
+}
+
+static size_t buildPoll(char *packet, byte talkToMe)
+{
+    size_t len = writeHeader(packet, 0x2000);
+    packet[len++] = talkToMe;
+    packet[len++] = 0;
+    return len;
+}
+
+// The ArtPoll a node sends asks for nothing, and mustn't turn off the
+// unsolicited replies the controller asked for
+static void testNodePoll()
+{
+    static char packet[32];
+    byte node2[4] = { 2, 0, 0, 20 };
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetPollLimit(8, 1000);
+
+    len = buildPoll(packet, 1 << 1);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    len = buildPoll(packet, 0);
+    node.ProcessPacket(node2, UDP_PORT_ARTNET, packet, len);
+
+    sends = 0;
+    node.SendPoll(0);
+    node.Service();
+    CHECK(sends == 1);
+}
+
+// With a discovery table a poll is answered to whoever sent it, a node
+// looking for subscribers as much as the controller
+static void testPollReplyToPoller()
+{
+    static char packet[32];
+    static ArtNetDiscovery discovery;
+    byte poller[4] = { 2, 0, 0, 77 };
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetDiscovery(&discovery);
+
+    len = buildPoll(packet, 1 << 1);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(memcmp(lastDestination, testSource, 4) == 0);
+
+    len = buildPoll(packet, 0);
+    node.ProcessPacket(poller, UDP_PORT_ARTNET, packet, len);
+    CHECK(memcmp(lastDestination, poller, 4) == 0);
+    node.SetDiscovery(0);
+}
+
+// TalkToMe bit 3 picks unicast diagnostics, clear they are broadcast
+static void testDiagnosticUnicast()
+{
+    static char packet[32];
+    static ArtNetDiagnostics diagnostics;
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetDiagnostics(&diagnostics);
+    diagnostics.SetLimit(ARTNET_DIAG_BURST, 0);
+
+    len = buildPoll(packet, 1 << 2);
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(node.Diagnostic(ARTNET_DIAGNOSTIC_CRITICAL, "broadcast"));
+    node.Service();
+    CHECK(lastDestination[3] == 255);
+
+    len = buildPoll(packet, (1 << 2) | (1 << 3));
+    node.ProcessPacket(testSource, UDP_PORT_ARTNET, packet, len);
+    CHECK(node.Diagnostic(ARTNET_DIAGNOSTIC_CRITICAL, "unicast"));
+    node.Service();
+    CHECK(memcmp(lastDestination, testSource, 4) == 0);
+    node.SetDiagnostics(0);
+}
+
+// An ArtPollReply for a node with one port of the given type patched to
+// Port-Address 0
+static size_t buildPollReply(char *packet, const byte ip[4], byte portType, byte bindIndex)
+{
+    memset(packet, 0, ARTNET_REPLY_BIND_INDEX + 2);
+    writeHeader(packet, 0x2100);
+    memcpy(&packet[ARTNET_REPLY_IP], ip, 4);
+    packet[ARTNET_REPLY_NUM_PORTS + 1] = 1;
+    packet[ARTNET_REPLY_PORT_TYPES] = portType;
+    packet[ARTNET_REPLY_BIND_INDEX] = bindIndex;
+    return ARTNET_REPLY_BIND_INDEX + 2;
+}
+
+// The node's own reply isn't a peer, only output ports subscribe, and a
+// controller doesn't share an entry with a node at the same IP
+static void testDiscovery()
+{
+    static char packet[256];
+    static ArtNetDiscovery discovery;
+    byte peer[4] = { 2, 0, 0, 30 };
+    byte ips[4][4];
+    const ArtNetPeer_t *found;
+    size_t len;
+
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    node.Configure(0, testIp);
+    node.SetDiscovery(&discovery);
+
+    len = buildPollReply(packet, testIp, 0xc0, 1);
+    node.ProcessPacket(testIp, UDP_PORT_ARTNET, packet, len);
+    CHECK(discovery.Count() == 0);
+
+    len = buildPollReply(packet, peer, 0x40, 0);
+    node.ProcessPacket(peer, UDP_PORT_ARTNET, packet, len);
+    CHECK(discovery.Subscribers(0, ips, 4) == 0);
+    len = buildPollReply(packet, peer, 0x80, 0);
+    node.ProcessPacket(peer, UDP_PORT_ARTNET, packet, len);
+    CHECK(discovery.Subscribers(0, ips, 4) == 1);
+
+    len = buildPoll(packet, 1 << 1);
+    node.ProcessPacket(peer, UDP_PORT_ARTNET, packet, len);
+    CHECK(discovery.Count() == 2);
+    found = discovery.Find(peer, ARTNET_PEER_CONTROLLER_INDEX);
+    CHECK(found && found->flags == ARTNET_PEER_CONTROLLER);
+    found = discovery.Find(peer, 1);
+    CHECK(found && found->flags == ARTNET_PEER_NODE);
+    node.SetDiscovery(0);
+}
+
+// An ArtAddress for bind index 1 setting the first input universe
+static size_t buildAddress(char *packet, byte universe)
+{
+    size_t len = writeHeader(packet, 0x6000);
+    memset(packet + len, 0, 95);
+    packet[len + 1] = 1;
+    packet[len + 84] = 0x80 | universe;
+    return len + 95;
+}
+
+// Only Art-Net of a supported version reaches a worker, anything else that
+// looks like ArtDmx is left to the control node.  Configuration reaches the
+// control node and every worker.
+static void testShardHeader()
+{
+    static char packet[600];
+    static byte controlTx[ARTNET_TX_SIZE];
+    ArtNetPacket_t offer;
+    unsigned long wait;
+
+    ArtNet control(testMac, 0, controlTx, sizeof(controlTx), testSetIP, testSend, testCallback, 1);
+    ArtNet worker(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 1);
+    ArtNetBase *nodes[1] = { &worker };
+    control.Configure(0, testIp);
+    worker.Configure(0, testIp);
+    control.SetInputUniverse(0, 0);
+    control.Commit();
+
+    memset(&offer, 0, sizeof(offer));
+    memcpy(offer.ip, testSource, 4);
+    offer.port = UDP_PORT_ARTNET;
+    offer.data = packet;
+    offer.length = buildDmx(packet, 0, 512, 512);
+    callbacks = 0;
+
+    ArtNetShards shards(&control, 1, nodes);
+    shards.Start();
+    memcpy(packet, "Foo-Net", 7);
+    shards.Offer(&offer);
+    memcpy(packet, "Art-Net", 7);
+    packet[11] = 13;
+    shards.Offer(&offer);
+    packet[11] = 14;
+    shards.Offer(&offer);
+    for (wait = 0; wait < 1000 && (shards.GetProcessedCount() < 1 || control.GetFailCount() < 1 || control.GetPacketCount() < 1); ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(shards.GetProcessedCount() == 1);
+    CHECK(worker.GetPacketCount() == 1);
+    CHECK(control.GetFailCount() == 1);
+    CHECK(control.GetPacketCount() == 1);
+
+    // An ArtAddress re-patches the worker along with the control node
+    offer.length = buildAddress(packet, 3);
+    CHECK(shards.Offer(&offer));
+    offer.length = buildDmx(packet, 3, 512, 512);
+    CHECK(shards.Offer(&offer));
+    for (wait = 0; wait < 1000 && shards.GetProcessedCount() < 3; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    shards.Stop();
+
+    CHECK(shards.GetProcessedCount() == 3);
+    CHECK(control.GetInputUniverse(0) == 3);
+    CHECK(worker.GetInputUniverse(0) == 3);
+    CHECK(callbacks == 2);
+}
+
+// Losing power part way through saving keeps the previous configuration
+static void testConfigTornWrite()
+{
+    char name[18];
+    unsigned char i;
+
+    EEPROM.clear();
+    ArtNet node(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 4);
+    node.Configure(0, testIp);
+    node.SetShortName((char*)"Old");
+    node.Commit();
+
+    // Service() saves a byte at a time once the configuration settles
+    node.SetShortName((char*)"New");
+    std::this_thread::sleep_for(std::chrono::milliseconds(ARTNET_COMMIT_DELAY + 10));
+    EEPROM.resetCounters();
+    for (i = 0; i < 8; ++i) {
+        node.Service();
+    }
+    CHECK(EEPROM.writes > 0);
+    ArtNet torn(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 4);
+    torn.GetShortName(name);
+    CHECK(strcmp(name, "Old") == 0);
+
+    node.Commit();
+    ArtNet saved(testMac, 0, testTx, sizeof(testTx), testSetIP, testSend, testCallback, 4);
+    saved.GetShortName(name);
+    CHECK(strcmp(name, "New") == 0);
+}
+
+int main()
+{
+    EEPROM.clear();
+    testOversizedDmx();
+    testInputBindIndex();
+    testNodePoll();
+    testPixelSync();
+    testSyncTimeout();
+    testMetricsPorts();
+    testMergeLtp();
+    testMergeSources();
+    testDiscovery();
+    testDiagnosticUnicast();
+    testPollReplyToPoller();
+    testShardHeader();
+    testConfigTornWrite();
+
+    if (failures) {
+        printf("%u checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
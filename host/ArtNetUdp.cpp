@@ -0,0 +1,198 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ArtNetUdp.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+static int udpSocket = -1;
+static int udpEpoll = -1;
+static unsigned char udpBatch = ARTNET_UDP_BATCH;
+static ArtNetUdpStats_t udpStats;
+
+static char udpBuffers[ARTNET_UDP_BATCH][ARTNET_UDP_MTU];
+static struct sockaddr_in udpAddresses[ARTNET_UDP_BATCH];
+static struct iovec udpVectors[ARTNET_UDP_BATCH];
+static struct mmsghdr udpMessages[ARTNET_UDP_BATCH];
+static ArtNetPacket_t udpPackets[ARTNET_UDP_BATCH];
+
+static void udpAddress(struct sockaddr_in *address, const byte ip[4], word port)
+{
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+    memcpy(&address->sin_addr.s_addr, ip, 4);
+    address->sin_port = htons(port);
+}
+
+int ArtNetUdpOpen(word port)
+{
+    struct sockaddr_in address;
+    struct epoll_event event;
+    int one = 1;
+    byte any[4] = { 0, 0, 0, 0 };
+
+    ArtNetUdpClose();
+    memset(&udpStats, 0, sizeof(udpStats));
+
+    udpSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (udpSocket < 0) {
+        return -1;
+    }
+    setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(udpSocket, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+    udpAddress(&address, any, port);
+    if (bind(udpSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        ArtNetUdpClose();
+        return -1;
+    }
+
+    udpEpoll = epoll_create1(0);
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    if (udpEpoll < 0 || epoll_ctl(udpEpoll, EPOLL_CTL_ADD, udpSocket, &event) < 0) {
+        ArtNetUdpClose();
+        return -1;
+    }
+    return udpSocket;
+}
+
+void ArtNetUdpClose()
+{
+    if (udpEpoll >= 0) close(udpEpoll);
+    if (udpSocket >= 0) close(udpSocket);
+    udpEpoll = -1;
+    udpSocket = -1;
+}
+
+void ArtNetUdpSetBatch(unsigned char batch)
+{
+    if (batch < 1) batch = 1;
+    if (batch > ARTNET_UDP_BATCH) batch = ARTNET_UDP_BATCH;
+    udpBatch = batch;
+}
+
+static int udpPoll(ArtNetBase *node, ArtNetShards *shards, int timeout)
+{
+    struct epoll_event event;
+    int ready, received, i, total = 0;
+
+    ready = epoll_wait(udpEpoll, &event, 1, timeout);
+    udpStats.waitCalls++;
+    if (ready <= 0) {
+        return ready < 0 && errno != EINTR ? -1 : 0;
+    }
+
+    do {
+        for (i = 0; i < udpBatch; ++i) {
+            udpVectors[i].iov_base = udpBuffers[i];
+            udpVectors[i].iov_len = ARTNET_UDP_MTU;
+            memset(&udpMessages[i].msg_hdr, 0, sizeof(struct msghdr));
+            udpMessages[i].msg_hdr.msg_name = &udpAddresses[i];
+            udpMessages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            udpMessages[i].msg_hdr.msg_iov = &udpVectors[i];
+            udpMessages[i].msg_hdr.msg_iovlen = 1;
+        }
+        received = recvmmsg(udpSocket, udpMessages, udpBatch, MSG_DONTWAIT, NULL);
+        udpStats.recvCalls++;
+        if (received <= 0) {
+            break;
+        }
+
+        for (i = 0; i < received; ++i) {
+            memcpy(udpPackets[i].ip, &udpAddresses[i].sin_addr.s_addr, 4);
+            udpPackets[i].port = ntohs(udpAddresses[i].sin_port);
+            udpPackets[i].data = udpBuffers[i];
+            udpPackets[i].length = udpMessages[i].msg_len;
+        }
+        if (node) {
+            node->ProcessPackets(udpPackets, received);
+        } else {
+            shards->Receive(udpPackets, received);
+        }
+        udpStats.received += received;
+        total += received;
+        // A short batch means the socket is empty, save the EAGAIN call
+    } while (received == udpBatch);
+
+    return total;
+}
+
+int ArtNetUdpPoll(ArtNetBase &node, int timeout)
+{
+    return udpPoll(&node, 0, timeout);
+}
+
+int ArtNetUdpPoll(ArtNetShards &shards, int timeout)
+{
+    return udpPoll(0, &shards, timeout);
+}
+
+void ArtNetUdpSend(const byte *data, size_t length, word, byte *dip, word dport)
+{
+    struct sockaddr_in address;
+
+    udpAddress(&address, dip, dport);
+    sendto(udpSocket, data, length, 0, (struct sockaddr*)&address, sizeof(address));
+    udpStats.sendCalls++;
+    udpStats.sent++;
+}
+
+void ArtNetUdpSendBatch(const ArtNetSend_t *sends, unsigned char count)
+{
+    static struct sockaddr_in addresses[ARTNET_UDP_BATCH];
+    static struct iovec vectors[ARTNET_UDP_BATCH];
+    static struct mmsghdr messages[ARTNET_UDP_BATCH];
+    unsigned char i, chunk;
+    int sent;
+
+    while (count) {
+        chunk = count > ARTNET_UDP_BATCH ? ARTNET_UDP_BATCH : count;
+        for (i = 0; i < chunk; ++i) {
+            udpAddress(&addresses[i], sends[i].ip, sends[i].dport);
+            vectors[i].iov_base = (void*)sends[i].data;
+            vectors[i].iov_len = sends[i].length;
+            memset(&messages[i].msg_hdr, 0, sizeof(struct msghdr));
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        sent = sendmmsg(udpSocket, messages, chunk, 0);
+        udpStats.sendCalls++;
+        if (sent <= 0) {
+            // Datagrams are unreliable anyway, drop the rest of the chunk
+            sent = chunk;
+        } else {
+            udpStats.sent += sent;
+        }
+        sends += sent;
+        count -= sent;
+    }
+}
+
+ArtNetUdpStats_t *ArtNetUdpGetStats()
+{
+    return &udpStats;
+}
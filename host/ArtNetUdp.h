@@ -0,0 +1,67 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Linux UDP backend for running the library as a gateway.  Datagrams are
+ * received with recvmmsg and passed to ArtNet::ProcessPackets in batches,
+ * and anything the node sends while processing them goes out in a single
+ * sendmmsg.  One socket is used for both, so the source port given by the
+ * node is ignored.
+ */
+
+#ifndef ARTNET_UDP_H
+#define ARTNET_UDP_H
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include "ArtNetShards.h"
+
+// Most datagrams received or sent per system call
+#define ARTNET_UDP_BATCH 64
+// Largest datagram received, anything longer is truncated
+#define ARTNET_UDP_MTU 1500
+
+typedef struct ArtNetUdpStatsTag
+{
+    unsigned long long received;
+    unsigned long long sent;
+    unsigned long long recvCalls;
+    unsigned long long sendCalls;
+    unsigned long long waitCalls;
+} ArtNetUdpStats_t;
+
+// Binds to port on every interface, 0 for any free port.  Returns the
+// socket or -1 on failure.
+int ArtNetUdpOpen(word port);
+void ArtNetUdpClose();
+// Datagrams per system call, from 1 to ARTNET_UDP_BATCH
+void ArtNetUdpSetBatch(unsigned char batch);
+// Waits up to timeout ms for data then processes everything waiting.
+// Returns the number of datagrams processed or -1 on error.
+int ArtNetUdpPoll(ArtNetBase &node, int timeout);
+// As above, handing the datagrams to a sharded runtime
+int ArtNetUdpPoll(ArtNetShards &shards, int timeout);
+// Send function for the ArtNet constructor
+void ArtNetUdpSend(const byte *data, size_t length, word sport, byte *dip, word dport);
+// Batch send function for ArtNet::SetSendBatch
+void ArtNetUdpSendBatch(const ArtNetSend_t *sends, unsigned char count);
+ArtNetUdpStats_t *ArtNetUdpGetStats();
+
+#endif
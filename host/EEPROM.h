@@ -0,0 +1,54 @@
+/*
+    ArtNet Library written for Arduino
+    by Chris Staite, yourDream
+    Copyright 2013
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * RAM backed EEPROM for host builds.  Every access is counted so the
+ * benchmarks can report how much EEPROM traffic each op code causes.
+ */
+
+#ifndef EEPROM_HOST_SHIM_H
+#define EEPROM_HOST_SHIM_H
+
+#include <Arduino.h>
+
+// Same size as the ATmega328 EEPROM
+#define EEPROM_HOST_SIZE 1024
+
+class EEPROMClass
+{
+  private:
+    byte data[EEPROM_HOST_SIZE];
+
+  public:
+    unsigned long reads;
+    unsigned long writes;
+
+    EEPROMClass();
+    byte read(int address);
+    void write(int address, byte value);
+    void update(int address, byte value);
+    int length();
+    // Return the contents to the erased state (all 0xff)
+    void clear();
+    void resetCounters();
+};
+
+extern EEPROMClass EEPROM;
+
+#endif